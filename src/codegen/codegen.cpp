@@ -1,1047 +1,594 @@
 #include "codegen.h"
 
+#include "ir/passes.h"
+#include "ir/print.h"
 #include "util.h"
 #include "symt/symt.h"
 
 // std
-#include <cstdio> 
+#include <algorithm>
+#include <bit>
+#include <cstdio>
 #include <exception>
 
-#define DIGITS "0123456789"
-
-// The output string
-std::string output;
-
-// The next unused temp value, increment after use
-size_t next_temp;
-
-// The result string, where something would go (so we dont need return values)
-std::string result;
-
-// The type of the result 
-Type result_type;
-
-// An additional result string for variable to put their actual location
-std::string location;
-
-// An additional value string for literals before they are converted into llvm form
-std::string literal_value;
-
-// The return type of the function (for return statements)
-Type return_type;
-
-// Flag if cg'd return, break, or continue
-bool terminator = false;
-
-// The stack declared variables and labels, (the vector is for multiple stack frames)
-std::vector<std::unordered_map<std::string, std::pair<std::string, Type>>> var_map;
-
-std::unordered_map<TypeKind, std::string> after_decimal({
-    {TypeKind::FLOAT, ".000000e+00"},
-    {TypeKind::INT, ""},
-});
-
-void store(std::string* write, Type type, const std::string& dst, const std::string& src, bool ignore_const = false)
+ExprResult Node::visit(Codegen* gen)
 {
-    if (type.is_const && !ignore_const) throw compiler_error("Trying to assign a const value");
-    else *write += "    store " + type_to_string(type) + " " + src + ", ptr " + dst + ", align " + std::to_string(type.size_of()) + "\n";
+    return visit_node(this, [&](auto* node) { return node->visit(gen); });
 }
 
-Type literal_cast(Type dst, Type src, const std::string& literal)
+uint32_t Codegen::function_id(const FuncEntry* entry)
 {
-    if (literal_value.size() != 0 && literal[0] != '%' && src != dst && src.t_kind != TypeKind::BOOL && dst.t_kind != TypeKind::BOOL)
-    {
-        if (dst.t_kind == TypeKind::INT || (dst.t_kind == TypeKind::UNSIGNED && dst.t_kind == TypeKind::UNSIGNED))
-        {
-            if (src.t_kind == TypeKind::FLOAT)
-            {
-                if (dst.size_of() == 1) result = std::to_string((char) std::stod(literal_value));
-                else if (dst.size_of() == 2) result = std::to_string((short) std::stod(literal_value));
-                else if (dst.size_of() == 4) result = std::to_string((int) std::stod(literal_value));
-                else result = std::to_string(std::stol(literal_value));
+    Module& module = get_module();
+    auto [it, inserted] = function_ids.try_emplace(entry, (uint32_t) module.functions.size());
+    if (inserted)
+    {
+        Function& fn = module.functions.emplace_back();
+        fn.name = entry->name;
+        fn.type = entry->type;
+        for (auto arg : entry->args) fn.args.push_back(arg.type);
+    }
+    return it->second;
+}
 
-                src = dst;
-            }
-            else if (src.t_kind == TypeKind::INT)
-            {
-                if (dst.size_of() > src.size_of())
-                {
-                    result = std::to_string((long) std::stol(literal_value));
-                    src = dst;
-                }
-                else 
-                {
-                    if (dst.size_of() == 1) result = std::to_string((char) std::stol(literal_value));
-                    else if (dst.size_of() == 2) result = std::to_string((short) std::stol(literal_value));
-                    else if (dst.size_of() == 4) result = std::to_string((int) std::stol(literal_value));
-                    else result = literal_value;
-
-                    src = dst;
-                }
-            }
-            else if (src.t_kind == TypeKind::UNSIGNED)
-            {
-                if (dst.size_of() > src.size_of())
-                {
-                    result = std::to_string(std::stol(literal_value));
-                    src = dst;
-                }
-                else 
-                {
-                    if (dst.size_of() == 1) result = std::to_string((unsigned char) std::stoul(literal_value));
-                    else if (dst.size_of() == 2) result = std::to_string((unsigned short) std::stoul(literal_value));
-                    else if (dst.size_of() == 4) result = std::to_string((unsigned int) std::stoul(literal_value));
-                    else result = std::to_string((unsigned long) std::stoul(literal_value)); 
-
-                    src = dst;
-                }
-            }
-        }
-        else if (dst.t_kind == TypeKind::UNSIGNED && src.t_kind == TypeKind::INT) 
-        {
-            if (dst.size_of() > src.size_of())
-            {
-                result = std::to_string((long) std::stol(literal_value));
-                src = dst;
-            }
-            else 
-            {
-                if (dst.size_of() == 1) result = std::to_string((unsigned char) std::stoul(literal_value));
-                else if (dst.size_of() == 2) result = std::to_string((unsigned short) std::stoul(literal_value));
-                else if (dst.size_of() == 4) result = std::to_string((unsigned int) std::stoul(literal_value));
-                else result = std::to_string((unsigned long) std::stoul(literal_value));
+uint32_t Codegen::global_id(const GlobalEntry* entry)
+{
+    Module& module = get_module();
+    auto [it, inserted] = global_ids.try_emplace(entry, (uint32_t) module.globals.size());
+    if (inserted) module.globals.push_back({entry->name, entry->type});
+    return it->second;
+}
 
-                src = dst;
-            }
-        }
-        else if (dst.t_kind == TypeKind::UNSIGNED && src.t_kind == TypeKind::FLOAT)
-        {
-            if (dst.size_of() == 1) result = std::to_string((unsigned char) std::stod(literal_value));
-            else if (dst.size_of() == 2) result = std::to_string((unsigned short) std::stod(literal_value));
-            else if (dst.size_of() == 4) result = std::to_string((unsigned int) std::stod(literal_value));
-            else result = std::to_string((unsigned long) std::stod(literal_value));
+Value Codegen::frame_slot(const DeclNode* decl)
+{
+    Type type = decl->type;
+    type.is_const = false;
+    uint64_t key = (uint64_t) decl->frame << 33 | (uint64_t) std::bit_cast<uint32_t>(type) << 1 | decl->address_taken;
+    auto [it, inserted] = frame_slots.try_emplace(key);
+    if (inserted) it->second = stack_slot(type);
+    return it->second;
+}
 
-            src = dst;
-        }
-        else if (dst.t_kind == TypeKind::FLOAT)
-        {
-            // For now no if statement is needed
-            result = strfloat_to_hexfloat(literal_value, dst);
-            src = dst;
-        }
-    }
+void store(Codegen* gen, Type type, Value dst, Value src, bool ignore_const = false)
+{
+    if (type.is_const && !ignore_const) throw compiler_error("Trying to assign a const value");
     else
     {
-        return {TypeKind::NULLTP, 0};
+        gen->store(type, src, dst);
     }
+}
+
+// Casts a constant by making it again in the new type instead of with an instruction, false if src can't be
+bool literal_cast(Codegen* gen, Type dst, const ExprResult& src, ExprResult& out)
+{
+    if (src.value.kind() != Value::CONST || src.type == dst) return false;
 
-    return src;
+    LiteralValue value = convert_literal(gen->get_module().consts[src.value.index()].value, src.type, dst);
+    if (!value) return false;
+    out = {gen->constant(dst, value), dst};
+    return true;
 }
 
-void cast(std::string* write, Type dst, Type src, const std::string& temp_to_cast)
+// Converts src to type dst, the result is never a variable
+ExprResult cast(Codegen* gen, Type dst, const ExprResult& src)
 {
     // Potential for result bugs maybe?
-    if (dst == src) 
-    {
-        result = temp_to_cast;
-        result_type = src;
-        location = "";
-        literal_value = "";
-        return; 
-    }
-    result_type = literal_cast(dst, src, temp_to_cast);
-    if (result_type != Type{TypeKind::NULLTP, 0}) 
-    {
-        location = ""; 
-        literal_value = "";
-        return;
-    }
+    if (dst == src.type) return {src.value, src.type};
+
+    ExprResult out;
+    if (literal_cast(gen, dst, src, out)) return out;
 
-    std::string cast;
+    Op cast;
 
     if (dst.t_kind == TypeKind::BOOL)
     {
-        if (src.t_kind == TypeKind::INT) sprinta(write, "    %", next_temp++, " = icmp ne ", type_to_string(src), " ", temp_to_cast, ", 0\n");
-        else if (src.t_kind == TypeKind::FLOAT) sprinta(write, "    %", next_temp++, " = fcmp une ", type_to_string(src), " ", temp_to_cast, ", 0.000000e+00\n");
-        else if (src.t_kind == TypeKind::BOOL) 
-        {
-            location = ""; 
-            literal_value = "";
-            return;
-        }
-        else throw compiler_error("Invalid type %s\n", type_to_string(src).c_str());
-
-        result = "%" + std::to_string(next_temp - 1);
-        result_type = Type{TypeKind::BOOL, 1};
-        location = ""; 
-        literal_value = "";
-        return;
+        Type bool_type = {TypeKind::BOOL, 1};
+        if (src.type.t_kind == TypeKind::INT) return {gen->compare(Op::ICMP, Pred::NE, src.type, src.value, gen->zero(src.type)), bool_type};
+        else if (src.type.t_kind == TypeKind::FLOAT) return {gen->compare(Op::FCMP, Pred::UNE, src.type, src.value, gen->zero(src.type)), bool_type};
+        else if (src.type.t_kind == TypeKind::BOOL) return {src.value, bool_type};
+        else throw compiler_error("Invalid type %s\n", type_to_string(src.type).data());
     }
-    else if (src.t_kind == TypeKind::FLOAT && dst.t_kind == TypeKind::FLOAT)
+    else if (src.type.t_kind == TypeKind::FLOAT && dst.t_kind == TypeKind::FLOAT)
     {
-        if (src.size_of() > dst.size_of()) cast = "fptrunc";
-        else cast = "fpext";
+        if (src.type.size_of() > dst.size_of()) cast = Op::FPTRUNC;
+        else cast = Op::FPEXT;
     }
-    else if (src.t_kind == TypeKind::FLOAT && dst.t_kind == TypeKind::INT) cast = "fptosi";
-    else if (dst.t_kind == TypeKind::FLOAT && src.t_kind == TypeKind::INT) cast = "sitofp";
-    else if (src.t_kind == TypeKind::FLOAT && (dst.t_kind == TypeKind::UNSIGNED || dst.t_kind == TypeKind::BOOL)) cast = "fptoui";
-    else if (dst.t_kind == TypeKind::FLOAT && src.t_kind == TypeKind::UNSIGNED) cast = "uitofp";
-    else 
+    else if (src.type.t_kind == TypeKind::FLOAT && dst.t_kind == TypeKind::INT) cast = Op::FPTOSI;
+    else if (dst.t_kind == TypeKind::FLOAT && src.type.t_kind == TypeKind::INT) cast = Op::SITOFP;
+    else if (src.type.t_kind == TypeKind::FLOAT && (dst.t_kind == TypeKind::UNSIGNED || dst.t_kind == TypeKind::BOOL)) cast = Op::FPTOUI;
+    else if (dst.t_kind == TypeKind::FLOAT && (src.type.t_kind == TypeKind::UNSIGNED || src.type.t_kind == TypeKind::BOOL)) cast = Op::UITOFP;
+    else
     {
-        if (src.size_of() > dst.size_of()) cast = "trunc";
-        else if (src.size_of() == dst.size_of()) 
-        {
-            if (src.t_kind == TypeKind::BOOL && dst.t_kind != TypeKind::BOOL) cast = "zext";
-            else
-            {
-                result_type = dst;
-                location = ""; 
-                literal_value = "";
-                return;
-            }
-        }
-        else if (src.t_kind == TypeKind::INT) cast = "sext";
-        else if (src.t_kind == TypeKind::UNSIGNED || dst.t_kind == TypeKind::UNSIGNED || src.t_kind == TypeKind::BOOL) cast = "zext";
-        else 
+        if (src.type.size_of() > dst.size_of()) cast = Op::TRUNC;
+        else if (src.type.size_of() == dst.size_of())
         {
-            result_type = dst;
-            location = ""; 
-            literal_value = "";
-            return;
+            // Same bits, only the type changes
+            if (src.type.t_kind == TypeKind::BOOL && dst.t_kind != TypeKind::BOOL) cast = Op::ZEXT;
+            else return {src.value, dst};
         }
+        else if (src.type.t_kind == TypeKind::INT) cast = Op::SEXT;
+        else if (src.type.t_kind == TypeKind::UNSIGNED || dst.t_kind == TypeKind::UNSIGNED || src.type.t_kind == TypeKind::BOOL) cast = Op::ZEXT;
+        else return {src.value, dst};
     }
 
-    sprinta(write, "    %", next_temp++, " = ", cast, " ", type_to_string(src), " ", temp_to_cast, " to ", type_to_string(dst), "\n");
-    result = "%" + std::to_string(next_temp - 1);
-    result_type = dst;
-    location = ""; 
-    literal_value = "";
+    return {gen->cast(cast, src.value, dst), dst};
 }
 
-std::string return_str(Type type)
+Module generate_ir(Node* node)
 {
-    if (type.num_pointers) return "    ret ptr null\n";
-    return "    ret " + type_to_string(type) + " 0" + after_decimal[type.t_kind] + "\n";
+    Module module;
+    Codegen gen(module);
+    node->visit(&gen);
+    return module;
 }
 
 std::string codegen(Node* node)
 {
-    node->visit(&output);
-
-    // Just cover the bases
-    // Fix double branches
-    size_t i = output.find("    br ");
-    size_t temp = output.find("    ret");
-    i = temp > i ? i : temp;
-    while (i != std::string::npos)
-    {
-        size_t j = output.find("    br ", i + 7);
-        temp = output.find("    ret", i + 7);
-        j = temp > j ? j : temp;
-        size_t k = output.find("\n", i);
-        k = output.find("\n", k + 1);
-        while (output[k - 1] == '\n') k = output.find("\n", k + 1);
-
-        if (j == std::string::npos) break;
-        if (k > j) 
-        {
-            output.erase(j, k - j + 1);
-            size_t i = output.find("    br ");
-            size_t temp = output.find("    ret");
-            i = temp > i ? i : temp;
-        }
-        else i = j;
-    }
-
-    return output;
+    Module module = generate_ir(node);
+    optimize(module);
+    return print_ir(module);
 }
 
-void ProgramNode::visit(std::string* write)
+ExprResult ProgramNode::visit(Codegen* gen)
 {
+    // Every function is added before any is built, the builder points into the module's functions
     for (auto x = forward.begin(); x != forward.end(); x++)
     {
-        (*x)->visit(write);
+        if ((*x)->node_type == NodeType::FUNCTION) gen->function_id(static_cast<FunctionNode*>(*x)->entry);
     }
+
+    for (auto x = forward.begin(); x != forward.end(); x++)
+    {
+        (*x)->visit(gen);
+    }
+    return {};
 }
 
-void ArgNode::visit(std::string* write)
+ExprResult ArgNode::visit(Codegen*)
 {
-
+    return {};
 }
 
-void BlockStmtNode::visit(std::string* write)
+ExprResult BlockStmtNode::visit(Codegen* gen)
 {
-    var_map.emplace_back();
-
-
     for (auto x = forward.begin(); x != forward.end(); x++)
     {
-        (*x)->visit(write);
-        if (terminator) break;
+        (*x)->visit(gen);
+        // Anything after a return, break, or continue is unreachable
+        if (gen->terminated()) break;
     }
-
-    var_map.pop_back();
+    return {};
 }
 
-void TerminatorCheckNode::visit(std::string* write)
+ExprResult TerminatorCheckNode::visit(Codegen* gen)
 {
-    this->forward->visit(write);
-    if (terminator) terminator = false;
+    return this->forward->visit(gen);
 }
 
-void FunctionNode::visit(std::string* write)
+ExprResult FunctionNode::visit(Codegen* gen)
 {
-    terminator = false;
-    std::string init_variable_allocs;
-    var_map.emplace_back();
-    // Only do declarations if no definition exists
-    if (!function_definitions[this->name.value].defined || this->defined)
+    Module& module = gen->get_module();
+    gen->next_loop = 0;
+    gen->local_slots.resize(slot_count);
+    gen->frame_slots.clear();
+    Value id(Value::FUNC, gen->function_id(entry));
+    Function& fn = module.functions[id.index()];
+
+    // Only do declarations if no definition exists, and only once
+    if (this->defined || (!entry->defined && std::find(module.order.begin(), module.order.end(), id) == module.order.end()))
     {
-        sprinta(write, "define dso_local ", type_to_string(type), " @", this->name.value, "(");
-        
-        if (!this->defined)
-        {
-            for (auto arg : args)
-            {
-                sprinta(write, type_to_string(arg.type), ", ");
-            }
-            
-            if (args.size() != 0)
-            {
-                write->pop_back();
-                write->pop_back();
-            }
-            sprinta(write, ") ");
-        }
-        else
-        {
-            next_temp = 0;
-            for (auto arg : args)
-            {
-                sprinta(write, type_to_string(arg.type), " %", next_temp++, ", ");
-            }
-            next_temp++;
-            
-            // A proxy next_temp for args
-            size_t arg_ctr = 0;
-            for (auto arg : args)
-            {
-                var_map.back()[arg.tok.value] = {"%" + std::to_string(next_temp), arg.type};
-                sprinta(&init_variable_allocs, "    %", next_temp, " = alloca ", type_to_string(arg.type), ", align ", arg.type.size_of(), "\n");
-                store(&init_variable_allocs, arg.type, "%" + std::to_string(next_temp++), "%" + std::to_string(arg_ctr++), true);
-            }
+        module.order.push_back(id);
+    }
 
-            if (args.size() != 0)
-            {
-                write->pop_back();
-                write->pop_back();
-            }
-            sprinta(write, ") ");
+    if (this->defined)
+    {
+        fn.defined = true;
+        gen->begin_function(fn);
+
+        // A proxy next_temp for args
+        uint32_t arg_ctr = 0;
+        for (auto arg : args)
+        {
+            Value slot = gen->stack_slot(arg.type);
+            gen->local_slots[arg_ctr] = {slot, arg.type};
+            store(gen, arg.type, slot, Value(Value::ARG, arg_ctr++), true);
         }
-    }
 
-    if (this->defined) 
-    {   
-        return_type = type;
-        sprinta(write, "{\n", init_variable_allocs);
-        statements.visit(write);
-        sprinta(write, return_str(type));
-        sprinta(write, "}\n\n");
+        gen->return_type = type;
+        statements.visit(gen);
+        gen->ret(type, gen->zero(type));
     }
-
-    var_map.pop_back();
+    return {};
 }
 
-void NoExpr::visit(std::string* write)
+ExprResult NoExpr::visit(Codegen*)
 {
-    result = "";
-    result_type = Type{TypeKind::NULLTP, 0};
-    return;
+    return {};
 }
 
-void UnaryOpNode::visit(std::string* write)
+ExprResult UnaryOpNode::visit(Codegen* gen)
 {
+    ExprResult operand = forward->visit(gen);
+    Type type = operand.type;
+
     switch (this->op)
     {
         case NodeKind::BITCOMPL:
         {
-            forward->visit(write);
-            if (result_type.t_kind == TypeKind::FLOAT) throw compiler_error("Invalid argument type ", (int) result_type.t_kind, " to unary expression: ", (int) this->op, "\n");
-            sprinta(write, "    %", next_temp, " = xor ", type_to_string(result_type), " ", result, ", -1\n");
-            result = "%" + std::to_string(next_temp++);
-            break;
+            if (type.t_kind == TypeKind::FLOAT) throw compiler_error("Invalid argument type ", (int) type.t_kind, " to unary expression: ", (int) this->op, "\n");
+            return {gen->binary(Op::XOR, type, operand.value, gen->constant(type, -1)), type};
         }
         case NodeKind::NEG:
         {
-            forward->visit(write);
-            if (result_type.t_kind == TypeKind::FLOAT)
-            {
-                sprinta(write, "    %", next_temp, " = fneg ", type_to_string(result_type), result, "\n");
-                result = "%" + std::to_string(next_temp++);
-            }
-            else
-            {
-                sprinta(write, "    %", next_temp, " = sub ", type_to_string(result_type), " 0, ",  result, "\n");
-                result = "%" + std::to_string(next_temp++);
-            }
-            break;
+            if (type.t_kind == TypeKind::FLOAT) return {gen->unary(Op::FNEG, type, operand.value), type};
+            return {gen->binary(Op::SUB, type, gen->zero(type), operand.value), type};
         }
         case NodeKind::NOT:
         {
-            forward->visit(write);
-
-            const char* op = result_type.t_kind == TypeKind::FLOAT ? "fcmp" : "icmp";
-            const char* cmp = result_type.t_kind == TypeKind::FLOAT ? "une" : "ne";
-            sprinta(write, "    %", next_temp, " = ", op, " ", cmp, " ", type_to_string(result_type), " ", result, ", 0", after_decimal[result_type.t_kind], "\n");
-            next_temp++;
-            sprinta(write, "    %", next_temp, " = xor i1 %", next_temp - 1, ", true\n");
-            next_temp++;
-            sprinta(write, "    %", next_temp, " = zext i1 %", next_temp - 1, " to i32\n");
-            result = "%" + std::to_string(next_temp++);
-            result_type = {TypeKind::INT, 4};
-            break;
+            Type bool_type = {TypeKind::BOOL, 1};
+            Type int_type = {TypeKind::INT, 4};
+            Op op = type.t_kind == TypeKind::FLOAT ? Op::FCMP : Op::ICMP;
+            Pred cmp = type.t_kind == TypeKind::FLOAT ? Pred::UNE : Pred::NE;
+            Value value = gen->compare(op, cmp, type, operand.value, gen->zero(type));
+            value = gen->binary(Op::XOR, bool_type, value, gen->constant(bool_type, 1));
+            return {gen->cast(Op::ZEXT, value, int_type), int_type};
         }
         case NodeKind::ADDR:
         {
-            forward->visit(write);
-            if (location.size() == 0) throw compiler_error("Error: Expected lvalue for to take address of");
-            result = location;
-            result_type.num_pointers++;
-            result_type.is_const = false;
-            break;
+            if (!operand.location) throw compiler_error("Error: Expected lvalue for to take address of");
+            type.num_pointers++;
+            type.is_const = false;
+            return {operand.location, type};
         }
         case NodeKind::DEREF:
         {
-            forward->visit(write);
-            if (result_type.num_pointers == 0) throw compiler_error("Error: Expected pointer type to derefernce");
-            result_type.num_pointers--;
-            result_type.is_const = false;
-            sprinta(write, "    %", next_temp, " = load ", type_to_string(result_type), ", ptr ", result, "\n");
-            location = result;
-            result = "%" + std::to_string(next_temp++);
-            literal_value = "";
-            return;
+            type.num_pointers--;
+            type.is_const = false;
+            return {gen->load(type, operand.value, 0), type, operand.value};
         }
-        default: 
+        default:
         {
-            forward->visit(write);
-            if (location.size() == 0) throw compiler_error("Error: Expected lvalue for operation: %d\n", (int) this->op);
-            std::string op;
-            if (this->op == NodeKind::PREFIXINC || this->op == NodeKind::POSTFIXINC) op = "add";
-            else if (this->op == NodeKind::PREFIXDEC || this->op == NodeKind::POSTFIXDEC) op = "sub";
+            if (!operand.location) throw compiler_error("Error: Expected lvalue for operation: %d\n", (int) this->op);
+            Op op;
+            if (this->op == NodeKind::PREFIXINC || this->op == NodeKind::POSTFIXINC) op = type.t_kind == TypeKind::FLOAT ? Op::FADD : Op::ADD;
+            else if (this->op == NodeKind::PREFIXDEC || this->op == NodeKind::POSTFIXDEC) op = type.t_kind == TypeKind::FLOAT ? Op::FSUB : Op::SUB;
             else throw compiler_error("must have forgotten something");
-            if (result_type.t_kind == TypeKind::FLOAT) op.insert(op.begin(), 'f');
 
-            sprinta(write, "    %", next_temp++, " = ", op, " ", type_to_string(result_type), " ", result, ", 1", after_decimal[result_type.t_kind], "\n");
-            store(write, result_type, location, "%" + std::to_string(next_temp - 1));
-            if (this->op == NodeKind::PREFIXINC || this->op == NodeKind::PREFIXDEC) result = "%" + std::to_string(next_temp - 1);
-            if (this->op == NodeKind::POSTFIXINC || this->op == NodeKind::POSTFIXDEC) result = "%" + std::to_string(next_temp - 2);
-            break;
+            Value changed = gen->binary(op, type, operand.value, gen->constant(type, 1));
+            store(gen, type, operand.location, changed);
+            // Postfix operators give the value from before the change
+            if (this->op == NodeKind::PREFIXINC || this->op == NodeKind::PREFIXDEC) return {changed, type};
+            return {operand.value, type};
         }
     }
+}
+
+// The instruction of an arithmetic operation on type
+static Op arith_op(NodeKind kind, Type type)
+{
+    bool is_float = type.t_kind == TypeKind::FLOAT;
+    bool is_unsigned = type.t_kind == TypeKind::UNSIGNED;
+    switch (kind)
+    {
+        case NodeKind::ADD: return is_float ? Op::FADD : Op::ADD;
+        case NodeKind::SUB: return is_float ? Op::FSUB : Op::SUB;
+        case NodeKind::MUL: return is_float ? Op::FMUL : Op::MUL;
+        case NodeKind::DIV: return is_float ? Op::FDIV : is_unsigned ? Op::UDIV : Op::SDIV;
+        default: return is_float ? Op::FREM : is_unsigned ? Op::UREM : Op::SREM;
+    }
+}
 
-    location = ""; 
-    literal_value = "";
+// The predicate of a comparison of type
+static Pred cmp_pred(NodeKind kind, Type type)
+{
+    bool is_float = type.t_kind == TypeKind::FLOAT;
+    bool is_unsigned = type.t_kind == TypeKind::UNSIGNED;
+    switch (kind)
+    {
+        case NodeKind::EQ: return is_float ? Pred::OEQ : Pred::EQ;
+        case NodeKind::NOTEQ: return is_float ? Pred::ONE : Pred::NE;
+        case NodeKind::GREATER: return is_float ? Pred::OGT : is_unsigned ? Pred::UGT : Pred::SGT;
+        case NodeKind::GREATEREQ: return is_float ? Pred::OGE : is_unsigned ? Pred::UGE : Pred::SGE;
+        case NodeKind::LESS: return is_float ? Pred::OLT : is_unsigned ? Pred::ULT : Pred::SLT;
+        default: return is_float ? Pred::OLE : is_unsigned ? Pred::ULE : Pred::SLE;
+    }
 }
 
-void BinaryOpNode::visit(std::string* write)
+ExprResult BinaryOpNode::visit(Codegen* gen)
 {
-    std::unordered_map<NodeKind, std::string> arith_op_to_str({
-        {NodeKind::ADD, "add"},
-        {NodeKind::SUB, "sub"},
-        {NodeKind::MUL, "mul"},
-        {NodeKind::DIV, "div"},
-        {NodeKind::MOD, "rem"},
-    });
-
-    std::unordered_map<NodeKind, std::string> cmp_op_to_str({
-        {NodeKind::EQ, "eq"},
-        {NodeKind::NOTEQ, "ne"},
-        {NodeKind::GREATER, "gt"},
-        {NodeKind::GREATEREQ, "ge"},
-        {NodeKind::LESS, "lt"},
-        {NodeKind::LESSEQ, "le"},
-    });
+    bool is_arith = op == NodeKind::ADD || op == NodeKind::SUB || op == NodeKind::MUL || op == NodeKind::DIV || op == NodeKind::MOD;
+    bool is_cmp = op == NodeKind::EQ || op == NodeKind::NOTEQ || op == NodeKind::GREATER || op == NodeKind::GREATEREQ || op == NodeKind::LESS || op == NodeKind::LESSEQ;
 
     // Convert types
-    lhs->visit(write);
-    std::string lhs_result = result;
-    Type lhs_type = result_type;
-    std::string lhs_location = location;
-    std::string lhs_lit_val = literal_value;
-    location = ""; 
-    literal_value = "";
-
-    rhs->visit(write);
-    std::string rhs_result = result;
-    Type rhs_type = result_type;
-    std::string rhs_lit_val = literal_value;
-    location = ""; 
-    literal_value = "";
-
-    if (arith_op_to_str.contains(op) || cmp_op_to_str.contains(op))
-    {
-        Type convert_to = bin_op_cast(lhs_type, rhs_type);
-        if (convert_to.num_pointers != 0)
-        {
-            Type ptr_type = lhs_type.num_pointers ? lhs_type : rhs_type;
-            Type ptr_base_type = ptr_type;
-            ptr_base_type.num_pointers = 0;
-            Type int_type = lhs_type.num_pointers ? rhs_type : lhs_type;
-            std::string ptr_result = lhs_type.num_pointers ? lhs_result : rhs_result;
-            std::string int_result = lhs_type.num_pointers ? rhs_result : lhs_result;
+    ExprResult lhs_result = lhs->visit(gen);
+    ExprResult rhs_result = rhs->visit(gen);
 
-            if ((op != NodeKind::SUB && op != NodeKind::ADD) || (lhs_type.num_pointers == 0 && op == NodeKind::SUB)) throw compiler_error("Invalid operands for binary expression: '%s' and '%s'", type_to_string(lhs_type).c_str(), type_to_string(rhs_type).c_str());
+    if (!is_arith && !is_cmp)
+    {
+        if (!lhs_result.location) throw compiler_error("Left side of assignment is not a variable");
+        ExprResult value = lhs_result.type != rhs_result.type ? cast(gen, lhs_result.type, rhs_result) : ExprResult{rhs_result.value, rhs_result.type};
+        store(gen, value.type, lhs_result.location, value.value);
+        return value;
+    }
 
-            cast(write, {TypeKind::UNSIGNED, 8}, int_type, int_result);
-            if (op == NodeKind::SUB) 
-            {
-                sprinta(write, "    %", next_temp++, " = sub ", type_to_string(result_type), " 0, ",  result, "\n");
-                result = "%" + std::to_string(next_temp - 1);
-            }
-            sprinta(write, "    %", next_temp++, " = getelementptr inbounds ", type_to_string(ptr_base_type), ", ptr ", ptr_result, ", i64 ", result, "\n");
-            
-            result = "%" + std::to_string(next_temp - 1);
-            result_type = ptr_type;
-            location = ""; 
-            literal_value = "";
-            return;
-        }
+    if (convert_to.num_pointers != 0)
+    {
+        const ExprResult& ptr = lhs_result.type.num_pointers ? lhs_result : rhs_result;
+        const ExprResult& offset = lhs_result.type.num_pointers ? rhs_result : lhs_result;
+        Type ptr_base_type = ptr.type;
+        ptr_base_type.num_pointers = 0;
 
-        if (lhs_type != convert_to)
-        {
-            literal_value = lhs_lit_val;
-            cast(write, convert_to, lhs_type, lhs_result);
-            lhs_result = result;
-        }
+        if ((op != NodeKind::SUB && op != NodeKind::ADD) || (lhs_result.type.num_pointers == 0 && op == NodeKind::SUB)) throw compiler_error("Invalid operands for binary expression: '%s' and '%s'", type_to_string(lhs_result.type).data(), type_to_string(rhs_result.type).data());
 
-        if (rhs_type != convert_to)
-        {
-            literal_value = rhs_lit_val;
-            cast(write, convert_to, rhs_type, rhs_result);
-            rhs_result = result;
-        }
+        ExprResult index = cast(gen, {TypeKind::UNSIGNED, 8}, offset);
+        if (op == NodeKind::SUB) index.value = gen->binary(Op::SUB, index.type, gen->zero(index.type), index.value);
+        return {gen->gep(ptr_base_type, ptr.value, index.value), ptr.type};
+    }
 
-        if (arith_op_to_str.contains(op))
-        {
-            std::string before_char = "";
-            if ((op == NodeKind::DIV || op == NodeKind::MOD) && convert_to.t_kind == TypeKind::INT) before_char = "s";
-            if ((op == NodeKind::DIV || op == NodeKind::MOD) && convert_to.t_kind == TypeKind::UNSIGNED) before_char = "u";
-            if (convert_to.t_kind == TypeKind::FLOAT) before_char = "f";
-            
-            // Output operation
-            sprinta(write, "    %", next_temp++, " = ", before_char, arith_op_to_str[op], " ", type_to_string(convert_to), " ", lhs_result, ", ", rhs_result, "\n");
-            result = "%" + std::to_string(next_temp - 1);
-            result_type = convert_to;
-        } 
-        else
-        {
-            std::string before_char = "";
-            std::string before_cmp_char = "";
-            if (convert_to.t_kind == TypeKind::FLOAT)
-            {
-                before_char = "f";
-                before_cmp_char = "o";
-            }
-            else if (convert_to.t_kind == TypeKind::INT)
-            {
-                before_char = "i";
-                if (op != NodeKind::EQ && op != NodeKind::NOTEQ) before_cmp_char = "s";
-            }
-            else if (convert_to.t_kind == TypeKind::UNSIGNED)
-            {
-                before_char = "i";
-                if (op != NodeKind::EQ && op != NodeKind::NOTEQ) before_cmp_char = "u";
-            }
+    if (lhs_result.type != convert_to) lhs_result = cast(gen, convert_to, lhs_result);
+    if (rhs_result.type != convert_to) rhs_result = cast(gen, convert_to, rhs_result);
 
-            sprinta(write, "    %", next_temp++, " = ", before_char, "cmp ", before_cmp_char, cmp_op_to_str[op], " ", type_to_string(convert_to), " ", lhs_result, ", ", rhs_result, "\n");
-            result = "%" + std::to_string(next_temp - 1);
-            result_type = {TypeKind::BOOL, 1};
-        }
-    }
-    else 
-    {
-        if (lhs_location.size() == 0) throw compiler_error("%s is not a variable", lhs_result.c_str());
-        literal_value = rhs_lit_val;
-        if (lhs_type != rhs_type) cast(write, lhs_type, rhs_type, rhs_result);
-        store(write, result_type, lhs_location, result);
-    }
+    if (is_arith) return {gen->binary(arith_op(op, convert_to), convert_to, lhs_result.value, rhs_result.value), convert_to};
 
-    location = ""; 
-    literal_value = "";
+    Op cmp = convert_to.t_kind == TypeKind::FLOAT ? Op::FCMP : Op::ICMP;
+    return {gen->compare(cmp, cmp_pred(op, convert_to), convert_to, lhs_result.value, rhs_result.value), {TypeKind::BOOL, 1}};
 }
 
-size_t find_last_label(std::string* write)
+ExprResult TernNode::visit(Codegen* gen)
 {
-    size_t last_label_loc = write->rfind(':');
-    if (last_label_loc == std::string::npos) last_label_loc = 0;
-    if (last_label_loc > (write->rfind('{') == std::string::npos ? 0 : write->rfind('{')))
-    {
-        size_t i = last_label_loc - 1;
-        while (std::string(DIGITS).find(write->at(i)) != std::string::npos) i--;
-        last_label_loc = std::stoull(write->substr(i + 1, last_label_loc - i - 1));
-    }
-    else last_label_loc = 0;
-    
-    return last_label_loc;
-}
-
-void TernNode::visit(std::string* write)
-{   
     // Convert types
-    condition->visit(write);
-    cast(write, Type{TypeKind::BOOL, 1}, result_type, result);
-    std::string condition_result = result;
-    location = ""; 
-    literal_value = "";
-
-    size_t lhs_begin = next_temp++;
-
-    std::string lhs_exec;
-    lhs->visit(&lhs_exec);
-    std::string lhs_result = result;
-    Type lhs_type = result_type;
-    std::string lhs_lit_val = literal_value;
-    location = ""; 
-    literal_value = "";
-
-    size_t save_next_temp = next_temp++;
-
-    std::string blank;
-    rhs->visit(&blank);
-    std::string rhs_result = result;
-    Type rhs_type = result_type;
-    std::string rhs_lit_val = literal_value;
-    location = ""; 
-    literal_value = "";
-
-    Type convert_to = lhs_type == rhs_type ? lhs_type : (this->forceboolout ? Type{TypeKind::BOOL, 1} : bin_op_cast(lhs_type, rhs_type));
-    next_temp = save_next_temp;
-
-    if (lhs_type != convert_to)
-    {
-        literal_value = lhs_lit_val;
-        cast(&lhs_exec, convert_to, lhs_type, lhs_result);
-        lhs_result = result;
-    }
-    
-    size_t rhs_begin = next_temp++;
-
-    std::string rhs_exec;
-    rhs->visit(&rhs_exec);
-    rhs_result = result;
-    rhs_type = result_type;
-    rhs_lit_val = literal_value;
-    location = ""; 
-    literal_value = "";
-
-    if (rhs_type != convert_to)
-    {
-        literal_value = rhs_lit_val;
-        cast(&rhs_exec, convert_to, rhs_type, rhs_result);
-        rhs_result = result;
-    }
-
-    sprinta(write, "    br i1 ", condition_result, ", label %", lhs_begin, ", label %", rhs_begin, "\n\n");
-    sprinta(write, lhs_begin, ":\n");
-    sprinta(write, lhs_exec);
-    size_t lhs_phi_loc = find_last_label(write);
-    sprinta(write, "    br label %", next_temp, "\n\n");
-    sprinta(write, rhs_begin, ":\n");
-    sprinta(write, rhs_exec);
-    size_t rhs_phi_loc = find_last_label(write);
-    sprinta(write, "    br label %", next_temp, "\n\n");
-    sprinta(write, next_temp++, ":\n");
-    sprinta(write, "    %", next_temp++, " = phi ", type_to_string(convert_to), " [ ", lhs_result, ", %", lhs_phi_loc, " ], [ ", rhs_result, ", %", rhs_phi_loc, " ]\n");
-
-    result = "%" + std::to_string(next_temp - 1);
-    result_type = convert_to;
-    location = ""; 
-    literal_value = "";
+    ExprResult condition_result = cast(gen, Type{TypeKind::BOOL, 1}, condition->visit(gen));
+
+    BlockId lhs_begin = gen->create_block();
+    BlockId rhs_begin = gen->create_block();
+    BlockId end = gen->create_block();
+    gen->cond_br(condition_result.value, lhs_begin, rhs_begin);
+
+    // The phi comes from the block each branch ends in, which can be a block of something nested in it
+    gen->place(lhs_begin);
+    ExprResult lhs_result = lhs->visit(gen);
+    if (lhs_result.type != convert_to) lhs_result = cast(gen, convert_to, lhs_result);
+    BlockId lhs_end = gen->current();
+    gen->br(end);
+
+    gen->place(rhs_begin);
+    ExprResult rhs_result = rhs->visit(gen);
+    if (rhs_result.type != convert_to) rhs_result = cast(gen, convert_to, rhs_result);
+    BlockId rhs_end = gen->current();
+    gen->br(end);
+
+    gen->place(end);
+    return {gen->phi(convert_to, {{lhs_result.value, lhs_end}, {rhs_result.value, rhs_end}}), convert_to};
 }
 
-void LiteralNode::visit(std::string* write)
+ExprResult LiteralNode::visit(Codegen* gen)
 {
-    literal_value = this->value.value;
-    result = this->value.value;
-    if (this->type.t_kind == TypeKind::FLOAT) result = strfloat_to_hexfloat(this->value.value, this->type);
-    result_type = this->type;
-    location = ""; 
+    return {gen->constant(this->type, this->value), this->type};
 }
 
-void VarNode::visit(std::string* write)
+ExprResult VarNode::visit(Codegen* gen)
 {
     // Lazy but works, load and give location (when storing ofcourse only location is needed, but ir removes unnecessary load)
-    for (auto i = var_map.rbegin(); i != var_map.rend(); i++)
+    if (loc == Location::LOCAL)
     {
-        if (i->contains(this->name.value))
-        {
-            sprinta(write, "    %", next_temp++, " = load ", type_to_string((*i)[this->name.value].second), ", ptr ", (*i)[this->name.value].first, ", align ", (*i)[this->name.value].second.size_of(), "\n");
-            result = "%" + std::to_string(next_temp - 1);
-            result_type = (*i)[this->name.value].second;
-            location = (*i)[this->name.value].first;
-            return;
-        }
-    }
-
-    if (global_definitions.contains(this->name.value))
-    {
-        sprinta(write, "    %", next_temp++, " = load ", type_to_string(global_definitions[this->name.value].type), ", ptr @", global_definitions[this->name.value].name, ", align ", global_definitions[this->name.value].type.size_of(), "\n");
-        result = "%" + std::to_string(next_temp - 1);
-        result_type = global_definitions[this->name.value].type;
-        location = "@" + global_definitions[this->name.value].name;
-        return;
+        auto [ptr, type] = gen->local_slots[slot];
+        return {gen->load(type, ptr, type.size_of()), type, ptr};
     }
 
-    throw compiler_error("Variable %s not declared\n", this->name.value.c_str());
+    Value ptr(Value::GLOBAL, gen->global_id(global));
+    return {gen->load(global->type, ptr, global->type.size_of()), global->type, ptr};
 }
 
-void CastNode::visit(std::string* write)
+ExprResult CastNode::visit(Codegen* gen)
 {
     // Convert types
-    this->forward->visit(write);
+    ExprResult value = this->forward->visit(gen);
 
     // Make sure const properly gets casted or casted away
-    result_type.is_const = this->type.is_const;
-    // Handle pointer casting 
+    value.type.is_const = this->type.is_const;
+    // Handle pointer casting
     // Both sides are pointers, just return
-    if (this->type.num_pointers && result_type.num_pointers)
-    {
-        result_type = this->type;
-        location = ""; 
-        literal_value = "";
-        return;
-    }
+    if (this->type.num_pointers && value.type.num_pointers) return {value.value, this->type};
     // If an integer is being cast to a pointer or vice versa, do inttoptr or ptrtoint
-    else if (this->type.num_pointers && (result_type.t_kind == TypeKind::INT || result_type.t_kind == TypeKind::BOOL || result_type.t_kind == TypeKind::UNSIGNED))
+    else if (this->type.num_pointers && (value.type.t_kind == TypeKind::INT || value.type.t_kind == TypeKind::BOOL || value.type.t_kind == TypeKind::UNSIGNED))
     {
-        sprinta(write, "    %", next_temp++, " = inttoptr ", type_to_string(result_type), " ", result, " to ", type_to_string(this->type), "\n");
-        result = "%" + std::to_string(next_temp - 1);
-        result_type = this->type;
-        location = ""; 
-        literal_value = "";
-        return;
+        return {gen->cast(Op::INTTOPTR, value.value, this->type), this->type};
     }
-    else if (result_type.num_pointers && (this->type.t_kind == TypeKind::INT || this->type.t_kind == TypeKind::BOOL || this->type.t_kind == TypeKind::UNSIGNED))
+    else if (value.type.num_pointers && (this->type.t_kind == TypeKind::INT || this->type.t_kind == TypeKind::BOOL || this->type.t_kind == TypeKind::UNSIGNED))
     {
-        sprinta(write, "    %", next_temp++, " = ptrtoint ", type_to_string(result_type), " ", result, " to ", type_to_string(this->type), "\n");
-        result = "%" + std::to_string(next_temp - 1);
-        result_type = this->type;
-        location = ""; 
-        literal_value = "";
-        return;
+        return {gen->cast(Op::PTRTOINT, value.value, this->type), this->type};
     }
     // Floats cannot be casted to pointers
-    else if ((this->type.num_pointers || result_type.num_pointers) && (this->type.t_kind == TypeKind::FLOAT || result_type.t_kind == TypeKind::FLOAT)) throw compiler_error("Cannot cast type %s to type %s\n", type_to_string(result_type).c_str(), type_to_string(this->type).c_str());
+    else if ((this->type.num_pointers || value.type.num_pointers) && (this->type.t_kind == TypeKind::FLOAT || value.type.t_kind == TypeKind::FLOAT)) throw compiler_error("Cannot cast type %s to type %s\n", type_to_string(value.type).data(), type_to_string(this->type).data());
 
     // If it is a normal type do a normal cast
-    cast(write, this->type, result_type, result);
-    result_type = this->type;
-    location = ""; 
-    literal_value = "";
+    return {cast(gen, this->type, value).value, this->type};
 }
 
-void FuncallNode::visit(std::string* write)
+ExprResult FuncallNode::visit(Codegen* gen)
 {
-    // Check if function exists
-    if (!function_definitions.contains(this->name.value)) throw compiler_error("Function %s not declared\n", this->name.value.c_str());
-
-    // Check if arguments are correct
-    if (this->args.size() != function_definitions[this->name.value].args.size()) throw compiler_error("Function %s called with wrong number of arguments\n", this->name.value.c_str());
+    std::vector<Value> funcall_args;
 
-    std::string funcall_args;
-    
-    // Check if arguments are correct and call the function with them, cast if needed
+    // Call the function with the arguments, cast if needed (resolve_names already checked there are the right number)
     size_t j = 0;
     for (auto i = args.begin(); i != args.end(); i++, j++)
     {
-        (*i)->visit(write);
-        if (result_type != function_definitions[this->name.value].args[0].type) cast(write, function_definitions[this->name.value].args[0].type, result_type, result);
-        sprinta(&funcall_args, type_to_string(result_type), " ", result, ", ");
-    }
-
-    sprinta(write, "    %", next_temp++, " = call ", type_to_string(function_definitions[this->name.value].type), " @", this->name.value, "(", funcall_args);
-
-    if (args.size() != 0) 
-    {
-        write->pop_back();
-        write->pop_back();
+        ExprResult arg = (*i)->visit(gen);
+        if (arg.type != entry->args[j].type) arg = cast(gen, entry->args[j].type, arg);
+        funcall_args.push_back(arg.value);
     }
-    sprinta(write, ")\n");
 
-    result = "%" + std::to_string(next_temp - 1);
-    result_type = function_definitions[this->name.value].type;
-    location = "";  
-    literal_value = "";
+    return {gen->call(Value(Value::FUNC, gen->function_id(entry)), entry->type, funcall_args), entry->type};
 }
 
-void DeclNode::visit(std::string* write)
+ExprResult DeclNode::visit(Codegen* gen)
 {
     // If the function is in global or if it is in stack scope
-    if (var_map.size() == 0)
+    if (loc == Location::GLOBAL)
     {
-        if ((this->defined && global_definitions[this->name.value].defined) || !global_definitions[this->name.value].defined)
+        Module& module = gen->get_module();
+        Value id(Value::GLOBAL, gen->global_id(global));
+        if (((this->defined && global->defined) || !global->defined) && std::find(module.order.begin(), module.order.end(), id) == module.order.end())
         {
-            sprinta(write, "@", this->name.value, " = dso_local global ", type_to_string(this->type), " ");
+            module.order.push_back(id);
 
-            if (assign) 
+            Value init = gen->zero(this->type);
+            if (assign)
             {
-                assign->visit(write);
-                // Only literal cast b/c no code can be executed
-                result_type = literal_cast(this->type, result_type, result);
-                if (result_type == Type{TypeKind::NULLTP, 1}) throw compiler_error("Global variable can only be declared as a literal");
-                literal_value = "";
-                location = ""; 
-                sprinta(write, result);
+                // Only literals b/c no code can be executed, fold_constants has made constant expressions into literals
+                if (assign->node_type != NodeType::LITERAL) throw compiler_error("Global variable can only be declared as a literal");
+                LiteralNode* literal = static_cast<LiteralNode*>(assign);
+                LiteralValue value = convert_literal(literal->value, literal->type, this->type);
+                // Only pointer initializers aren't converted, a number that doesn't fit the type has no value to give it
+                if (!value && !literal->type.num_pointers && !this->type.num_pointers) throw compiler_error("Global variable initializer is out of range of its type");
+                init = gen->constant(this->type, value ? value : literal->value);
             }
-            else sprinta(write, "0", after_decimal[type.t_kind]);
-            sprinta(write, ", align ", type.size_of(), "\n\n");
-        } 
-    }  
-    else 
-    {
-        if (var_map.back().contains(this->name.value)) throw compiler_error("Redefinition of local variable %s", this->name.value.c_str());
-        var_map.back()[this->name.value] = {"%" + std::to_string(next_temp++), this->type};
-        sprinta(write, "    ", var_map.back()[this->name.value].first, " = alloca ", type_to_string(this->type), ", align ", this->type.size_of(), "\n");
-        if (assign) 
-        {
-            assign->visit(write);
-            if (result_type != this->type) cast(write, this->type, result_type, result);
-            store(write, this->type, var_map.back()[this->name.value].first, result);
+            module.globals[id.index()].init = init;
         }
-        else
+    }
+    else
+    {
+        Value var = gen->frame_slot(this);
+        gen->local_slots[slot] = {var, this->type};
+        if (assign)
         {
-            std::string null_value = this->type.num_pointers ? "null" : "0" + after_decimal[this->type.t_kind];
-            store(write, this->type, var_map.back()[this->name.value].first, null_value);
+            ExprResult value = assign->visit(gen);
+            if (value.type != this->type) value = cast(gen, this->type, value);
+            // Initializing a const local isn't an assignment to it
+            store(gen, this->type, var, value.value, true);
         }
-    } 
+        else store(gen, this->type, var, gen->zero(this->type), true);
+    }
+    return {};
 }
 
-void BreakNode::visit(std::string* write)
+ExprResult BreakNode::visit(Codegen* gen)
 {
-    // Stupid hacks
-    terminator = true;
-    sprinta(write, "{break}\n");
+    gen->br(gen->loops.back().break_block);
+    return {};
 }
 
-void ContinueNode::visit(std::string* write)
+ExprResult ContinueNode::visit(Codegen* gen)
 {
-    // Stupid hacks
-    terminator = true;
-    sprinta(write, "{continue}\n");
+    gen->br(gen->loops.back().continue_block);
+    return {};
 }
 
-void RetNode::visit(std::string* write)
+ExprResult RetNode::visit(Codegen* gen)
 {
-    terminator = true;
-    value->visit(write);
-    if (result_type != return_type) cast(write, return_type, result_type, result);
-    sprinta(write, "    ret ", type_to_string(result_type), " ", result, "\n");
+    ExprResult ret = value->visit(gen);
+    if (ret.type != gen->return_type) ret = cast(gen, gen->return_type, ret);
+    gen->ret(ret.type, ret.value);
+    return {};
 }
 
-void IfNode::visit(std::string* write)
+ExprResult IfNode::visit(Codegen* gen)
 {
-    condition->visit(write);
-    location = ""; 
-    literal_value = "";
-    
     // Make sure that we are branching with a boolean value
-    cast(write, Type{TypeKind::BOOL, 1}, result_type, result);
-    
-    // Do the first branch
-    size_t label_save = next_temp;
-    sprinta(write, "    br i1 ", result, ", label %", next_temp++, ", label %");
-    
-    // Save the code for the if true statement, so that next_temp gets incremented properly
-    std::string if_true_execute;
-    statement->visit(&if_true_execute);
-    location = ""; 
-    literal_value = "";
-
-    // Save the label for the end of the if true statment (leads to else or end)
-    sprinta(write, next_temp++, "\n\n", label_save, ":\n");
-    label_save = next_temp - 1;
-    
-    // Save the code for the else statement, so that next_temp gets incremented properly (if there is one)
-    std::string else_execute; 
-    if (else_stmt) else_stmt->visit(&else_execute);
-
-    // Find our end label (could be the old label_save or the next_temp)
-    size_t end_label = else_stmt ? next_temp++ : label_save;
-
-    // Print the code for the if true statement
-    sprinta(write, if_true_execute);
-    sprinta(write, "    br label %", end_label, "\n\n");
-    sprinta(write, label_save, ":\n");
-    
-    // Print the code for the if else statement (if there is one)
+    ExprResult condition_result = cast(gen, Type{TypeKind::BOOL, 1}, condition->visit(gen));
+
+    // Without an else, the false branch is the end
+    BlockId if_true = gen->create_block();
+    BlockId if_false = gen->create_block();
+    BlockId end = else_stmt ? gen->create_block() : if_false;
+    gen->cond_br(condition_result.value, if_true, if_false);
+
+    gen->place(if_true);
+    statement->visit(gen);
+    gen->br(end);
+    gen->place(if_false);
+
+    // The code for the else statement (if there is one)
     if (else_stmt)
     {
-        sprinta(write, else_execute);
-        sprinta(write, "    br label %", end_label, "\n\n");
-        sprinta(write, end_label, ":\n");
+        else_stmt->visit(gen);
+        gen->br(end);
+        gen->place(end);
     }
-
-    location = ""; 
-    literal_value = "";
+    return {};
 }
 
-void ForNode::visit(std::string* write)
+ExprResult ForNode::visit(Codegen* gen)
 {
-    var_map.emplace_back();
-    initial->visit(write);
-    location = ""; 
-    literal_value = "";
+    initial->visit(gen);
 
-    var_map.emplace_back();
+    uint32_t id = gen->next_loop++;
+    BlockId cond = gen->create_block("for.cond", id);
+    BlockId body = gen->create_block("for.body", id);
+    BlockId inc = gen->create_block("for.inc", id);
+    BlockId end_loop = gen->create_block("for.end", id);
 
-    size_t begin_loop = next_temp++;
-    sprinta(write, "    br label %", begin_loop, "\n\n");
-    sprinta(write, begin_loop, ":\n");
+    gen->br(cond);
+    gen->place(cond);
 
-    condition->visit(write);
-    location = ""; 
-    literal_value = "";
+    // Make sure that we are branching with a boolean value, no condition is always true
+    ExprResult condition_result = condition->visit(gen);
+    if (condition_result.type == Type{TypeKind::NULLTP, 0}) condition_result = {gen->constant(Type{TypeKind::BOOL, 1}, 1), Type{TypeKind::BOOL, 1}};
+    else condition_result = cast(gen, Type{TypeKind::BOOL, 1}, condition_result);
 
-    // Make sure that we are branching with a boolean value
-    if (result_type == Type{TypeKind::NULLTP, 0})
-    {
-        result = "1";
-        result_type = Type{TypeKind::BOOL, 1};
-    } 
-    else cast(write, Type{TypeKind::BOOL, 1}, result_type, result);
-
-    std::string condition_loc = result;
-    size_t check_condition = next_temp++;
-    size_t end_loop_label;
-    std::string execute;
-    std::string end_loop;
-
-    statement->visit(&execute);
-    location = "";
-    literal_value = "";
+    gen->cond_br(condition_result.value, body, end_loop);
+    gen->place(body);
 
-    end_loop_label = next_temp++;
+    gen->loops.push_back({end_loop, inc});
+    statement->visit(gen);
+    gen->loops.pop_back();
 
-    end->visit(&end_loop);
-    location = "";
-    literal_value = "";
+    gen->br(inc);
+    gen->place(inc);
 
-    size_t i = execute.find("{break}");
-    while (i != std::string::npos)
-    {
-        execute.erase(i, 7);
-        std::string input_this;
-        sprinta(&input_this, "    br label %", next_temp, "\n\n");
-        execute.insert(i, input_this);
-        i = execute.find("{break}", i);
-    }
+    end->visit(gen);
 
-    i = execute.find("{continue}");
-    while (i != std::string::npos)
-    {
-        execute.erase(i, 10);
-        std::string input_this;
-        sprinta(&input_this, "    br label %", end_loop_label, "\n\n");
-        execute.insert(i, input_this);
-        i = execute.find("{continue}", i);
-    }
-
-    sprinta(write, "    br i1 ", condition_loc, ", label %", check_condition, ", label %", next_temp, "\n\n");
-    sprinta(write, check_condition, ":\n");
-    sprinta(write, execute);
-    sprinta(write, "    br label %", end_loop_label, "\n\n");
-    sprinta(write, end_loop_label, ":\n");
-    sprinta(write, end_loop);
-    sprinta(write, "    br label %", begin_loop, "\n\n");
-    sprinta(write, next_temp++, ":\n");
-
-    var_map.pop_back();
-    var_map.pop_back();
+    gen->br(cond);
+    gen->place(end_loop);
+    return {};
 }
 
-void WhileNode::visit(std::string* write)
+ExprResult WhileNode::visit(Codegen* gen)
 {
-    size_t begin_loop = next_temp++;
-    sprinta(write, "    br label %", begin_loop, "\n\n");
-    sprinta(write, begin_loop, ":\n");
+    uint32_t id = gen->next_loop++;
 
     if (do_on)
     {
-        statement->visit(write);
-        location = ""; 
-        literal_value = "";
-        condition->visit(write);
-        location = ""; 
-        literal_value = "";
+        BlockId body = gen->create_block("do.body", id);
+        BlockId cond = gen->create_block("do.cond", id);
+        BlockId end = gen->create_block("do.end", id);
 
-        // Make sure that we are branching with a boolean value
-        cast(write, Type{TypeKind::BOOL, 1}, result_type, result);
+        gen->br(body);
+        gen->place(body);
 
-        size_t i = write->find("{break}");
-        while (i != std::string::npos)
-        {
-            write->erase(i, 7);
-            std::string input_this;
-            sprinta(write, "    br label %", next_temp);
-            write->insert(i, input_this);
-            i = write->find("{break}", i);
-        }
+        gen->loops.push_back({end, cond});
+        statement->visit(gen);
+        gen->loops.pop_back();
 
-        i = write->find("{continue}");
-        while (i != std::string::npos)
-        {
-            write->erase(i, 10);
-            std::string input_this;
-            sprinta(&input_this, "    br label %", next_temp);
-            write->insert(i, input_this);
-            i = write->find("{continue}", i);
-        }
+        gen->br(cond);
+        gen->place(cond);
+
+        // Make sure that we are branching with a boolean value
+        ExprResult condition_result = cast(gen, Type{TypeKind::BOOL, 1}, condition->visit(gen));
 
-        sprinta(write, "    br i1 ", result, ", label %", begin_loop, ", label %", next_temp, "\n\n");
-        sprinta(write, next_temp++, ":\n");
+        gen->cond_br(condition_result.value, body, end);
+        gen->place(end);
     }
     else
     {
-        condition->visit(write);
-        location = ""; 
-        literal_value = "";
-
-        // Make sure that we are branching with a boolean value
-        cast(write, Type{TypeKind::BOOL, 1}, result_type, result);
+        BlockId cond = gen->create_block("while.cond", id);
+        BlockId body = gen->create_block("while.body", id);
+        BlockId end = gen->create_block("while.end", id);
 
-        std::string condition_loc = result;
-        size_t check_condition = next_temp++;
-        std::string execute;
+        gen->br(cond);
+        gen->place(cond);
 
-        statement->visit(&execute);
-        location = "";
-        literal_value = "";
+        // Make sure that we are branching with a boolean value
+        ExprResult condition_result = cast(gen, Type{TypeKind::BOOL, 1}, condition->visit(gen));
 
-        size_t i = execute.find("{break}");
-        while (i != std::string::npos)
-        {
-            execute.erase(i, 7);
-            std::string input_this;
-            sprinta(&input_this, "    br label %", next_temp);
-            execute.insert(i, input_this);
-            i = execute.find("{break}", i);
-        }
+        gen->cond_br(condition_result.value, body, end);
+        gen->place(body);
 
-        i = execute.find("{continue}");
-        while (i != std::string::npos)
-        {
-            execute.erase(i, 10);
-            std::string input_this;
-            sprinta(&input_this, "    br label %", begin_loop);
-            execute.insert(i, input_this);
-            i = execute.find("{continue}", i);
-        }
+        gen->loops.push_back({end, cond});
+        statement->visit(gen);
+        gen->loops.pop_back();
 
-        sprinta(write, "    br i1 ", condition_loc, ", label %", check_condition, ", label %", next_temp, "\n\n");
-        sprinta(write, check_condition, ":\n");
-        sprinta(write, execute);
-        sprinta(write, "    br label %", begin_loop, "\n\n");
-        sprinta(write, next_temp++, ":\n");
+        gen->br(cond);
+        gen->place(end);
     }
+    return {};
 }
\ No newline at end of file
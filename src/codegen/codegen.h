@@ -1,5 +1,63 @@
 #pragma once
 
+#include "ir/ir.h"
 #include "node/node.h"
 
+// std
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// What an expression evaluates to, returned by value from the visit functions
+struct ExprResult
+{
+    Value value;
+    Type type = {TypeKind::NULLTP, 0};
+    // The pointer the value was loaded from if the expression is a variable, none otherwise
+    Value location = {};
+
+    ExprResult() = default;
+    ExprResult(Value value, Type type, Value location = {}) : value(value), type(type), location(location) {}
+};
+
+// A builder with everything codegen needs to know about the program and the function being generated
+// All of it lives here instead of in globals, so codegen is reentrant
+struct Codegen : IrBuilder
+{
+    Codegen(Module& module) : IrBuilder(module) {}
+
+    // The return type of the function (for return statements)
+    Type return_type = {TypeKind::NULLTP, 0};
+
+    // The stack slot and type of every local of the function, by the slot resolve_names gave it
+    std::vector<std::pair<Value, Type>> local_slots;
+
+    // The alloca of every frame position, type, and if the address is taken, for the function
+    // Locals that are never in scope together share one, but locals whose address is taken get their own, so they
+    // don't keep the others from being promoted
+    std::unordered_map<uint64_t, Value> frame_slots;
+
+    // The blocks break and continue branch to, for every loop around the statement being generated
+    // Loop blocks are named with the loop's number in the function
+    struct LoopBlocks
+    {
+        BlockId break_block;
+        BlockId continue_block;
+    };
+
+    std::vector<LoopBlocks> loops;
+    uint32_t next_loop = 0;
+
+    // The module function or global of every symtable entry, added to the module the first time it is asked for
+    std::unordered_map<const FuncEntry*, uint32_t> function_ids;
+    std::unordered_map<const GlobalEntry*, uint32_t> global_ids;
+
+    uint32_t function_id(const FuncEntry* entry);
+    uint32_t global_id(const GlobalEntry* entry);
+    Value frame_slot(const DeclNode* decl);
+};
+
+// Builds the IR of a checked program
+Module generate_ir(Node* node);
+// The LLVM IR text of a checked program, optimized
 std::string codegen(Node* node);
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "compile.h"
+
+#include "parser/parser.h"
+#include "symt/symt.h"
+#include "sema/resolve.h"
+#include "sema/types.h"
+#include "sema/fold.h"
+#include "codegen/codegen.h"
+
+void check_program(Node* node)
+{
+    generate_symtables(node);
+    resolve_names(node);
+    check_types(node);
+}
+
+void run_passes(Node* node)
+{
+    check_program(node);
+    fold_constants(node);
+}
+
+std::string compile(Tokenizer& tokens)
+{
+    Node* node = parse_program(tokens);
+    run_passes(node);
+    return codegen(node);
+}
+
+void reset_compiler()
+{
+    node_arena.release();
+    function_definitions.clear();
+    global_definitions.clear();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "lexer/token.h"
+#include "node/node.h"
+
+// std
+#include <string>
+
+// The steps dcc runs on a program, so everything that compiles one (dcc, the tests and the benches) does it the same way
+
+// Builds the symtables of a parsed program, resolves its names and checks its types
+void check_program(Node* node);
+
+// Everything that runs between parsing and codegen: check_program, then constant folding
+void run_passes(Node* node);
+
+// Parses the tokens and returns the optimized LLVM IR text of the program
+std::string compile(Tokenizer& tokens);
+
+// Frees the nodes and clears the symtables of the programs compiled so far, so another one can be compiled
+void reset_compiler();
@@ -0,0 +1,123 @@
+#include "cfg.h"
+
+// std
+#include <utility>
+
+DomTree::DomTree(const Function& fn)
+{
+    size_t n = fn.blocks.size();
+    order.assign(n, NO_ID);
+    idom.assign(n, NO_ID);
+    if (fn.layout.empty()) return;
+
+    // Postorder with an explicit stack, nested ifs and loops can be deeper than the call stack
+    std::vector<BlockId> postorder;
+    std::vector<bool> seen(n);
+    std::vector<std::pair<BlockId, uint32_t>> stack{{fn.layout.front(), 0}};
+    seen[fn.layout.front()] = true;
+    while (!stack.empty())
+    {
+        auto& [block, next] = stack.back();
+        if (next < fn.blocks[block].succs.size())
+        {
+            BlockId succ = fn.blocks[block].succs[next++];
+            if (!seen[succ])
+            {
+                seen[succ] = true;
+                stack.push_back({succ, 0});
+            }
+        }
+        else
+        {
+            postorder.push_back(block);
+            stack.pop_back();
+        }
+    }
+
+    rpo.assign(postorder.rbegin(), postorder.rend());
+    for (uint32_t i = 0; i < rpo.size(); i++) order[rpo[i]] = i;
+
+    // Walks up from two blocks until they meet, blocks closer to the entry have a lower position
+    auto intersect = [&](BlockId a, BlockId b) {
+        while (a != b)
+        {
+            while (order[a] > order[b]) a = idom[a];
+            while (order[b] > order[a]) b = idom[b];
+        }
+        return a;
+    };
+
+    BlockId entry = rpo.front();
+    idom[entry] = entry;
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (size_t i = 1; i < rpo.size(); i++)
+        {
+            BlockId block = rpo[i];
+            BlockId dom = NO_ID;
+            for (BlockId pred : fn.blocks[block].preds)
+            {
+                if (idom[pred] == NO_ID) continue;
+                dom = dom == NO_ID ? pred : intersect(pred, dom);
+            }
+            if (dom != idom[block])
+            {
+                idom[block] = dom;
+                changed = true;
+            }
+        }
+    }
+
+    // Children in reverse postorder, counted and then placed
+    child_begin.assign(n + 1, 0);
+    for (size_t i = 1; i < rpo.size(); i++) child_begin[idom[rpo[i]] + 1]++;
+    for (size_t i = 0; i < n; i++) child_begin[i + 1] += child_begin[i];
+    child_list.resize(rpo.size() ? rpo.size() - 1 : 0);
+    std::vector<uint32_t> fill(child_begin.begin(), child_begin.end() - 1);
+    for (size_t i = 1; i < rpo.size(); i++) child_list[fill[idom[rpo[i]]]++] = rpo[i];
+
+    // Number the tree for dominates, again without recursion
+    pre.assign(n, NO_ID);
+    post.assign(n, 0);
+    tree_order.reserve(rpo.size());
+    uint32_t clock = 0;
+    std::vector<std::pair<BlockId, uint32_t>> walk{{entry, 0}};
+    pre[entry] = clock++;
+    tree_order.push_back(entry);
+    while (!walk.empty())
+    {
+        auto& [block, next] = walk.back();
+        if (next < child_begin[block + 1] - child_begin[block])
+        {
+            BlockId child = child_list[child_begin[block] + next++];
+            pre[child] = clock++;
+            tree_order.push_back(child);
+            walk.push_back({child, 0});
+        }
+        else
+        {
+            post[block] = clock++;
+            walk.pop_back();
+        }
+    }
+}
+
+std::vector<std::vector<BlockId>> DomTree::frontiers(const Function& fn) const
+{
+    std::vector<std::vector<BlockId>> frontier(fn.blocks.size());
+    for (BlockId block : rpo)
+    {
+        const std::vector<BlockId>& preds = fn.blocks[block].preds;
+        if (preds.size() < 2) continue;
+        for (BlockId pred : preds)
+        {
+            // Every block from the predecessor up to (not including) block's dominator has block in its frontier
+            for (BlockId runner = pred; reachable(runner) && runner != idom[block]; runner = idom[runner])
+            {
+                if (frontier[runner].empty() || frontier[runner].back() != block) frontier[runner].push_back(block);
+            }
+        }
+    }
+    return frontier;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ir.h"
+
+// std
+#include <span>
+#include <vector>
+
+// The dominator tree of a function, built with the iterative algorithm of Cooper, Harvey and Kennedy
+// Blocks that can't be reached from the entry aren't part of the tree
+struct DomTree
+{
+    // Reachable blocks in reverse postorder, the entry first
+    std::vector<BlockId> rpo;
+    // The position of every block in rpo, NO_ID if it is unreachable
+    std::vector<uint32_t> order;
+    // Immediate dominator of every block, the entry is its own and unreachable blocks have NO_ID
+    std::vector<BlockId> idom;
+
+    DomTree(const Function& fn);
+
+    bool reachable(BlockId block) const { return order[block] != NO_ID; }
+    // If every path from the entry to b goes through a (a block dominates itself)
+    bool dominates(BlockId a, BlockId b) const { return pre[a] <= pre[b] && post[b] <= post[a]; }
+    // Blocks block immediately dominates
+    std::span<const BlockId> children(BlockId block) const { return {child_list.data() + child_begin[block], child_begin[block + 1] - child_begin[block]}; }
+    // Blocks of the tree in preorder, a block comes before every block it dominates
+    const std::vector<BlockId>& preorder() const { return tree_order; }
+
+    // The dominance frontier of every block, where the blocks it dominates stop
+    std::vector<std::vector<BlockId>> frontiers(const Function& fn) const;
+private:
+    // Children of every block, packed one block after the other
+    std::vector<uint32_t> child_begin;
+    std::vector<BlockId> child_list;
+
+    // When each block is entered and left in a walk of the tree
+    std::vector<uint32_t> pre;
+    std::vector<uint32_t> post;
+    std::vector<BlockId> tree_order;
+};
\ No newline at end of file
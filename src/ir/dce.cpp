@@ -0,0 +1,323 @@
+#include "passes.h"
+
+// std
+#include <algorithm>
+#include <vector>
+
+// Branches on a constant become jumps, blocks nothing jumps to any more are dropped, and every instruction whose
+// result isn't used by a store, call or terminator is deleted, along with the stores to allocas nothing reads
+// Comparisons, xors and integer casts of constants are worked out first, so a condition that only depends on
+// constants (like a local that is never changed, once it is promoted) is known
+
+namespace
+{
+
+// The width in bits of an integer or pointer type
+int bit_width(Type type)
+{
+    if (type.num_pointers) return 64;
+    return type.t_kind == TypeKind::BOOL ? 1 : type.size * 8;
+}
+
+// The bits of an integer constant, zero extended from its width
+uint64_t bits_of(const Constant& c)
+{
+    int width = bit_width(c.type);
+    return width == 64 ? (uint64_t) c.value.i : (uint64_t) c.value.i & ((1ull << width) - 1);
+}
+
+// The value of an integer constant, sign extended from its width
+int64_t signed_of(const Constant& c)
+{
+    int shift = 64 - bit_width(c.type);
+    return (int64_t) (bits_of(c) << shift) >> shift;
+}
+
+bool compare(Pred pred, const Constant& a, const Constant& b)
+{
+    switch (pred)
+    {
+        case Pred::EQ: return bits_of(a) == bits_of(b);
+        case Pred::NE: return bits_of(a) != bits_of(b);
+        case Pred::SGT: return signed_of(a) > signed_of(b);
+        case Pred::SGE: return signed_of(a) >= signed_of(b);
+        case Pred::SLT: return signed_of(a) < signed_of(b);
+        case Pred::SLE: return signed_of(a) <= signed_of(b);
+        case Pred::UGT: return bits_of(a) > bits_of(b);
+        case Pred::UGE: return bits_of(a) >= bits_of(b);
+        case Pred::ULT: return bits_of(a) < bits_of(b);
+        default: return bits_of(a) <= bits_of(b);
+    }
+}
+
+struct DeadCode
+{
+    Module& module;
+    Function& fn;
+
+    // What every removed instruction is replaced with
+    std::vector<Value> replace;
+
+    DeadCode(Module& module, Function& fn) : module(module), fn(fn), replace(fn.insts.size()) {}
+
+    Value resolve(Value value) const
+    {
+        while (value.kind() == Value::INST && replace[value.index()]) value = replace[value.index()];
+        return value;
+    }
+
+    const Constant* constant(Value value) const
+    {
+        return value.kind() == Value::CONST ? &module.consts[value.index()] : nullptr;
+    }
+
+    // The value an instruction always has, none if it isn't known
+    Value fold(InstId i)
+    {
+        const Inst& inst = fn.insts[i];
+
+        // A phi whose incoming values are all the same value (or the phi itself) is that value
+        if (inst.op == Op::PHI)
+        {
+            Value same;
+            for (uint32_t e = 0; e < inst.extra_count; e += 2)
+            {
+                Value value = fn.extra[inst.extra_begin + e];
+                if (value == same || value == Value(Value::INST, i)) continue;
+                if (same) return {};
+                same = value;
+            }
+            return same;
+        }
+
+        const Constant* a = constant(inst.ops[0]);
+        if (!a || a->type.t_kind == TypeKind::FLOAT || a->type.num_pointers) return {};
+
+        LiteralValue out;
+        out.kind = LiteralValue::INT;
+        switch (inst.op)
+        {
+            case Op::ZEXT: out.i = bits_of(*a); break;
+            case Op::SEXT: out.i = signed_of(*a); break;
+            case Op::TRUNC: out.i = a->value.i; break;
+            case Op::XOR:
+            case Op::ICMP:
+            {
+                const Constant* b = constant(inst.ops[1]);
+                if (!b) return {};
+                out.i = inst.op == Op::XOR ? a->value.i ^ b->value.i : compare(inst.pred, *a, *b);
+                break;
+            }
+            default: return {};
+        }
+        return module.constant(fn.result_type(inst), out);
+    }
+
+    // Replaces every instruction whose value is known, blocks are in layout order so most operands are already
+    // replaced when the instruction using them is reached
+    void fold_all()
+    {
+        InstId next;
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = next)
+            {
+                next = fn.insts[i].next;
+                fn.for_each_operand(fn.insts[i], [&](Value& value) { value = resolve(value); });
+                if (Value value = fold(i))
+                {
+                    replace[i] = value;
+                    fn.remove(i);
+                }
+            }
+        }
+    }
+
+    // Removes one edge between two blocks, and the incoming value of the phis of to for it
+    void remove_edge(BlockId from, BlockId to)
+    {
+        std::vector<BlockId>& succs = fn.blocks[from].succs;
+        std::vector<BlockId>& preds = fn.blocks[to].preds;
+        succs.erase(std::find(succs.begin(), succs.end(), to));
+        preds.erase(std::find(preds.begin(), preds.end(), from));
+
+        for (InstId i = fn.blocks[to].first; i != NO_ID; i = fn.insts[i].next)
+        {
+            Inst& phi = fn.insts[i];
+            if (phi.op != Op::PHI) continue;
+            Value* incoming = &fn.extra[phi.extra_begin];
+            for (uint32_t e = 0; e < phi.extra_count; e += 2)
+            {
+                if (incoming[e + 1] != Value(Value::BLOCK, from)) continue;
+                std::copy(incoming + e + 2, incoming + phi.extra_count, incoming + e);
+                phi.extra_count -= 2;
+                break;
+            }
+        }
+    }
+
+    // Turns conditional branches on constants, and to the same block both ways, into jumps
+    bool simplify_branches()
+    {
+        bool changed = false;
+        for (BlockId block : fn.layout)
+        {
+            InstId last = fn.blocks[block].last;
+            if (last == NO_ID || fn.insts[last].op != Op::CONDBR) continue;
+
+            Inst& inst = fn.insts[last];
+            const Constant* condition = constant(inst.ops[0]);
+            BlockId on_true = inst.ops[1].index();
+            BlockId on_false = inst.ops[2].index();
+            if (!condition && on_true != on_false) continue;
+
+            BlockId target = condition && !(condition->value.i & 1) ? on_false : on_true;
+            BlockId dropped = target == on_true ? on_false : on_true;
+            inst.op = Op::BR;
+            inst.ops = {Value(Value::BLOCK, target), {}, {}};
+            remove_edge(block, dropped);
+            changed = true;
+        }
+        return changed;
+    }
+
+    // Drops the blocks that can't be reached from the entry
+    bool remove_unreachable()
+    {
+        std::vector<bool> reachable(fn.blocks.size());
+        std::vector<BlockId> stack{fn.layout.front()};
+        reachable[fn.layout.front()] = true;
+        while (!stack.empty())
+        {
+            BlockId block = stack.back();
+            stack.pop_back();
+            for (BlockId succ : fn.blocks[block].succs)
+            {
+                if (reachable[succ]) continue;
+                reachable[succ] = true;
+                stack.push_back(succ);
+            }
+        }
+
+        bool changed = false;
+        for (BlockId block : fn.layout)
+        {
+            if (reachable[block]) continue;
+            changed = true;
+            while (!fn.blocks[block].succs.empty()) remove_edge(block, fn.blocks[block].succs.back());
+        }
+        if (changed) std::erase_if(fn.layout, [&](BlockId block) { return !reachable[block]; });
+        return changed;
+    }
+
+    // An alloca that is only ever the pointer of stores is never read, so its stores can go, and then it can
+    // Returns if any store was removed
+    bool remove_write_only_allocas()
+    {
+        std::vector<bool> read(fn.insts.size());
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next)
+            {
+                Inst& inst = fn.insts[i];
+                for (size_t op = 0; op < inst.ops.size(); op++)
+                {
+                    Value value = inst.ops[op];
+                    if (value.kind() == Value::INST && !(inst.op == Op::STORE && op == 1)) read[value.index()] = true;
+                }
+                for (uint32_t e = 0; e < inst.extra_count; e++)
+                {
+                    Value value = fn.extra[inst.extra_begin + e];
+                    if (value.kind() == Value::INST) read[value.index()] = true;
+                }
+            }
+        }
+
+        bool removed = false;
+        InstId next;
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = next)
+            {
+                next = fn.insts[i].next;
+                const Inst& inst = fn.insts[i];
+                bool unread_alloca = inst.op == Op::ALLOCA && !read[i];
+                bool unread_store = inst.op == Op::STORE && inst.ops[1].kind() == Value::INST && fn.insts[inst.ops[1].index()].op == Op::ALLOCA && !read[inst.ops[1].index()];
+                if (unread_alloca || unread_store) fn.remove(i);
+                removed |= unread_store;
+            }
+        }
+        return removed;
+    }
+
+    // Deletes every instruction that nothing with a side effect depends on
+    void remove_unused()
+    {
+        std::vector<bool> live(fn.insts.size());
+        std::vector<InstId> worklist;
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next)
+            {
+                Op op = fn.insts[i].op;
+                if (op != Op::STORE && op != Op::CALL && !is_terminator(op)) continue;
+                live[i] = true;
+                worklist.push_back(i);
+            }
+        }
+
+        while (!worklist.empty())
+        {
+            InstId i = worklist.back();
+            worklist.pop_back();
+            fn.for_each_operand(fn.insts[i], [&](Value& value) {
+                if (value.kind() != Value::INST || live[value.index()]) return;
+                live[value.index()] = true;
+                worklist.push_back(value.index());
+            });
+        }
+
+        InstId next;
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = next)
+            {
+                next = fn.insts[i].next;
+                if (!live[i]) fn.remove(i);
+            }
+        }
+    }
+
+    void run()
+    {
+        // Folding a branch can leave a phi with one incoming value, which can make another branch's condition known
+        bool changed = true;
+        while (changed)
+        {
+            fold_all();
+            changed = simplify_branches();
+            changed |= remove_unreachable();
+        }
+
+        // Uses in blocks laid out before the instruction they used were missed by the folding
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next)
+            {
+                fn.for_each_operand(fn.insts[i], [&](Value& value) { value = resolve(value); });
+            }
+        }
+
+        // Loads nothing uses would count as reads, so those go first, and the values only the removed stores used after
+        remove_unused();
+        if (remove_write_only_allocas()) remove_unused();
+    }
+};
+
+}
+
+void eliminate_dead_code(Module& module, Function& fn)
+{
+    if (fn.layout.empty()) return;
+    DeadCode(module, fn).run();
+}
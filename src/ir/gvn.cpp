@@ -0,0 +1,271 @@
+#include "passes.h"
+#include "cfg.h"
+
+// std
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Dominator based value numbering (Briggs, Cooper and Simpson): a walk of the dominator tree keeps a table of the
+// expressions computed in the blocks that dominate the current one, and an instruction already in it is a copy
+// Loads are only reused in a block whose only predecessor is its dominator, the end of which the walk has just seen,
+// so a store on some other path into the block can't be missed
+
+namespace
+{
+
+// Arithmetic, comparisons, casts and geps, whose result only depends on their operands
+constexpr bool is_pure(Op op) { return op >= Op::GEP && op <= Op::PTRTOINT; }
+
+constexpr bool is_commutative(const Inst& inst)
+{
+    switch (inst.op)
+    {
+        case Op::ADD: case Op::MUL: case Op::FADD: case Op::FMUL: case Op::XOR: return true;
+        case Op::ICMP: return inst.pred == Pred::EQ || inst.pred == Pred::NE;
+        case Op::FCMP: return inst.pred == Pred::OEQ || inst.pred == Pred::ONE || inst.pred == Pred::UNE;
+        default: return false;
+    }
+}
+
+struct ExprKey
+{
+    Op op;
+    Pred pred;
+    uint32_t type;
+    Value lhs;
+    Value rhs;
+
+    bool operator==(const ExprKey&) const = default;
+};
+
+struct ExprHash
+{
+    size_t operator()(const ExprKey& key) const
+    {
+        uint64_t hash = ((uint64_t) key.op << 40) ^ ((uint64_t) key.pred << 32) ^ key.type;
+        hash = hash * 0x9E3779B97F4A7C15 ^ key.lhs.bits;
+        hash = hash * 0x9E3779B97F4A7C15 ^ key.rhs.bits;
+        return hash ^ (hash >> 29);
+    }
+};
+
+// What a pointer is known to hold, from a load of it or a store to it
+struct KnownLoad
+{
+    Value ptr;
+    Type type;
+    Value value;
+};
+
+// At most this many pointers are remembered, so a store is never checked against more than that
+constexpr size_t MAX_KNOWN_LOADS = 32;
+
+struct Numbering
+{
+    Module& module;
+    Function& fn;
+
+    // What every removed instruction is replaced with
+    std::vector<Value> replace;
+
+    // The expressions of the dominating blocks, and the keys to take out again when the walk leaves a block
+    std::unordered_map<ExprKey, Value, ExprHash> exprs;
+    std::vector<ExprKey> undo;
+
+    // Allocas whose address is only ever the pointer of loads and stores, no other pointer can point to them
+    std::vector<bool> private_alloca;
+
+    Numbering(Module& module, Function& fn) : module(module), fn(fn), replace(fn.insts.size()), private_alloca(fn.insts.size()) {}
+
+    Value resolve(Value value) const
+    {
+        while (value.kind() == Value::INST && replace[value.index()]) value = replace[value.index()];
+        return value;
+    }
+
+    bool is_alloca(Value value) const
+    {
+        return value.kind() == Value::INST && fn.insts[value.index()].op == Op::ALLOCA;
+    }
+
+    void find_private_allocas()
+    {
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next)
+            {
+                if (fn.insts[i].op == Op::ALLOCA) private_alloca[i] = true;
+            }
+        }
+
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next)
+            {
+                Inst& inst = fn.insts[i];
+                for (size_t op = 0; op < inst.ops.size(); op++)
+                {
+                    bool is_pointer = (inst.op == Op::LOAD && op == 0) || (inst.op == Op::STORE && op == 1);
+                    if (!is_pointer && is_alloca(inst.ops[op])) private_alloca[inst.ops[op].index()] = false;
+                }
+                for (uint32_t e = 0; e < inst.extra_count; e++)
+                {
+                    Value value = fn.extra[inst.extra_begin + e];
+                    if (is_alloca(value)) private_alloca[value.index()] = false;
+                }
+            }
+        }
+    }
+
+    // The alloca or global a pointer points into, or the pointer itself if that isn't known
+    Value base_of(Value ptr) const
+    {
+        while (ptr.kind() == Value::INST && fn.insts[ptr.index()].op == Op::GEP) ptr = fn.insts[ptr.index()].ops[0];
+        return ptr;
+    }
+
+    bool is_private(Value base) const
+    {
+        return is_alloca(base) && private_alloca[base.index()];
+    }
+
+    // If a store through one pointer can change what a load through the other gives
+    bool may_alias(Value a, Value b) const
+    {
+        Value base_a = base_of(a);
+        Value base_b = base_of(b);
+        if (base_a == base_b) return true;
+
+        // Two different allocas or globals never overlap, and nothing but the alloca itself points into a private one
+        bool known_a = is_alloca(base_a) || base_a.kind() == Value::GLOBAL;
+        bool known_b = is_alloca(base_b) || base_b.kind() == Value::GLOBAL;
+        if (known_a && known_b) return false;
+        return !is_private(base_a) && !is_private(base_b);
+    }
+
+    // Replaces a pure instruction with the same expression from a dominating block, or adds it to the table
+    bool number(InstId i)
+    {
+        const Inst& inst = fn.insts[i];
+        Type type = inst.type;
+        type.is_const = false;
+        ExprKey key{inst.op, inst.pred, std::bit_cast<uint32_t>(type), inst.ops[0], inst.ops[1]};
+        if (is_commutative(inst) && key.rhs.bits < key.lhs.bits) std::swap(key.lhs, key.rhs);
+
+        auto [it, inserted] = exprs.try_emplace(key, Value(Value::INST, i));
+        if (inserted)
+        {
+            undo.push_back(key);
+            return false;
+        }
+        replace[i] = it->second;
+        return true;
+    }
+
+    // Reuses a load of a pointer that is known, otherwise the pointer is known to hold what it loads
+    bool number_load(InstId i, std::vector<KnownLoad>& known)
+    {
+        const Inst& inst = fn.insts[i];
+        for (const KnownLoad& load : known)
+        {
+            if (load.ptr != inst.ops[0] || load.type != inst.type) continue;
+            replace[i] = load.value;
+            return true;
+        }
+        remember(known, {inst.ops[0], inst.type, Value(Value::INST, i)});
+        return false;
+    }
+
+    void remember(std::vector<KnownLoad>& known, const KnownLoad& load)
+    {
+        if (known.size() == MAX_KNOWN_LOADS) known.erase(known.begin());
+        known.push_back(load);
+    }
+
+    void number_block(BlockId block, std::vector<KnownLoad>& known)
+    {
+        InstId next;
+        for (InstId i = fn.blocks[block].first; i != NO_ID; i = next)
+        {
+            next = fn.insts[i].next;
+            Inst& inst = fn.insts[i];
+            fn.for_each_operand(inst, [&](Value& value) { value = resolve(value); });
+
+            if (is_pure(inst.op))
+            {
+                if (number(i)) fn.remove(i);
+            }
+            else if (inst.op == Op::LOAD)
+            {
+                if (number_load(i, known)) fn.remove(i);
+            }
+            else if (inst.op == Op::STORE)
+            {
+                // The store overwrites what every pointer that may point to the same memory is known to hold
+                std::erase_if(known, [&](const KnownLoad& load) { return may_alias(load.ptr, inst.ops[1]); });
+                remember(known, {inst.ops[1], inst.type, inst.ops[0]});
+            }
+            else if (inst.op == Op::CALL)
+            {
+                // A call can store to anything but a private alloca
+                std::erase_if(known, [&](const KnownLoad& load) { return !is_private(base_of(load.ptr)); });
+            }
+        }
+    }
+
+    void run()
+    {
+        find_private_allocas();
+        DomTree dom(fn);
+
+        // Walk the tree with an explicit stack, every block keeps what its pointers hold at its end for its children
+        struct Visit { BlockId block; uint32_t next_child; size_t mark; std::vector<KnownLoad> known; };
+        std::vector<Visit> stack;
+        stack.push_back({dom.rpo.front(), 0, undo.size(), {}});
+        number_block(stack.back().block, stack.back().known);
+        while (!stack.empty())
+        {
+            Visit& top = stack.back();
+            auto children = dom.children(top.block);
+            if (top.next_child < children.size())
+            {
+                BlockId child = children[top.next_child++];
+                const std::vector<BlockId>& preds = fn.blocks[child].preds;
+                std::vector<KnownLoad> known;
+                if (preds.size() == 1 && preds[0] == top.block) known = top.known;
+
+                stack.push_back({child, 0, undo.size(), std::move(known)});
+                number_block(child, stack.back().known);
+            }
+            else
+            {
+                while (undo.size() > top.mark)
+                {
+                    exprs.erase(undo.back());
+                    undo.pop_back();
+                }
+                stack.pop_back();
+            }
+        }
+
+        // Phis, and blocks the walk doesn't reach, can use instructions from blocks after them
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next)
+            {
+                fn.for_each_operand(fn.insts[i], [&](Value& value) { value = resolve(value); });
+            }
+        }
+    }
+};
+
+}
+
+void number_values(Module& module, Function& fn)
+{
+    if (fn.layout.empty()) return;
+    Numbering(module, fn).run();
+}
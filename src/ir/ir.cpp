@@ -0,0 +1,257 @@
+#include "ir.h"
+
+#include "error/error.h"
+
+// std
+#include <bit>
+
+Type Function::result_type(const Inst& inst) const
+{
+    switch (inst.op)
+    {
+        case Op::ALLOCA:
+        case Op::GEP: return pointer_to(inst.type);
+        case Op::ICMP:
+        case Op::FCMP: return {TypeKind::BOOL, 1};
+        case Op::STORE:
+        case Op::BR:
+        case Op::CONDBR:
+        case Op::RET: return {TypeKind::NULLTP, 0};
+        default: return inst.type;
+    }
+}
+
+const Inst* Function::terminator(BlockId block) const
+{
+    InstId last = blocks[block].last;
+    return last != NO_ID && is_terminator(insts[last].op) ? &insts[last] : nullptr;
+}
+
+InstId Function::append(BlockId block, const Inst& inst)
+{
+    return insert(block, NO_ID, inst);
+}
+
+InstId Function::insert(BlockId block, InstId before, const Inst& inst)
+{
+    if (insts.size() > Value::INDEX_MASK) throw compiler_error("Too many instructions in function %s", name.data());
+    InstId id = insts.size();
+    insts.push_back(inst);
+    insts[id].block = block;
+
+    Block& b = blocks[block];
+    InstId prev = before == NO_ID ? b.last : insts[before].prev;
+    insts[id].prev = prev;
+    insts[id].next = before;
+    if (prev != NO_ID) insts[prev].next = id;
+    else b.first = id;
+    if (before != NO_ID) insts[before].prev = id;
+    else b.last = id;
+    return id;
+}
+
+void Function::remove(InstId inst)
+{
+    Inst& i = insts[inst];
+    Block& b = blocks[i.block];
+    if (i.prev != NO_ID) insts[i.prev].next = i.next;
+    else b.first = i.next;
+    if (i.next != NO_ID) insts[i.next].prev = i.prev;
+    else b.last = i.prev;
+    i.prev = i.next = NO_ID;
+    i.block = NO_ID;
+}
+
+Value Module::constant(Type type, LiteralValue value)
+{
+    type.is_const = false;
+    // Constants are kept in the form the value has in its type, so equal values of a type are the same constant
+    value = normalize_literal(type, value);
+
+    ConstKey key{value.kind == LiteralValue::FLOAT ? std::bit_cast<uint64_t>(value.f) : (uint64_t) value.i, std::bit_cast<uint32_t>(type)};
+    auto [it, inserted] = const_ids.try_emplace(key, (uint32_t) consts.size());
+    if (inserted)
+    {
+        if (consts.size() > Value::INDEX_MASK) throw compiler_error("Too many constants");
+        consts.push_back({type, value});
+    }
+    return Value(Value::CONST, it->second);
+}
+
+Type Module::type_of(const Function& fn, Value value) const
+{
+    switch (value.kind())
+    {
+        case Value::INST: return fn.result_type(fn.insts[value.index()]);
+        case Value::ARG: return fn.args[value.index()];
+        case Value::CONST: return consts[value.index()].type;
+        case Value::GLOBAL: return pointer_to(globals[value.index()].type);
+        case Value::FUNC: return pointer_to(functions[value.index()].type);
+        default: return {TypeKind::NULLTP, 0};
+    }
+}
+
+void IrBuilder::begin_function(Function& fn)
+{
+    this->fn = &fn;
+    last_alloca = NO_ID;
+    place(create_block());
+}
+
+BlockId IrBuilder::create_block(std::string_view name, uint32_t name_id)
+{
+    if (fn->blocks.size() > Value::INDEX_MASK) throw compiler_error("Too many blocks in function %s", fn->name.data());
+    fn->blocks.push_back(Block{name, name_id});
+    return fn->blocks.size() - 1;
+}
+
+void IrBuilder::place(BlockId block)
+{
+    fn->layout.push_back(block);
+    this->block = block;
+}
+
+Value IrBuilder::emit(const Inst& inst)
+{
+    return Value(Value::INST, fn->append(block, inst));
+}
+
+void IrBuilder::edge(BlockId from, BlockId to)
+{
+    fn->blocks[from].succs.push_back(to);
+    fn->blocks[to].preds.push_back(from);
+}
+
+Value IrBuilder::constant(Type type, int64_t value)
+{
+    LiteralValue literal;
+    literal.kind = LiteralValue::INT;
+    literal.i = value;
+    return module->constant(type, literal);
+}
+
+Value IrBuilder::zero(Type type)
+{
+    return constant(type, LiteralValue{});
+}
+
+Value IrBuilder::stack_slot(Type type)
+{
+    Inst inst{Op::ALLOCA};
+    inst.type = type;
+    inst.align = type.size_of();
+    BlockId entry = fn->layout.front();
+    last_alloca = fn->insert(entry, last_alloca == NO_ID ? fn->blocks[entry].first : fn->insts[last_alloca].next, inst);
+    return Value(Value::INST, last_alloca);
+}
+
+Value IrBuilder::load(Type type, Value ptr, uint8_t align)
+{
+    Inst inst{Op::LOAD};
+    inst.type = type;
+    inst.align = align;
+    inst.ops[0] = ptr;
+    return emit(inst);
+}
+
+void IrBuilder::store(Type type, Value value, Value ptr)
+{
+    Inst inst{Op::STORE};
+    inst.type = type;
+    inst.align = type.size_of();
+    inst.ops = {value, ptr};
+    emit(inst);
+}
+
+Value IrBuilder::gep(Type elem, Value ptr, Value index)
+{
+    Inst inst{Op::GEP};
+    inst.type = elem;
+    inst.ops = {ptr, index};
+    return emit(inst);
+}
+
+Value IrBuilder::binary(Op op, Type type, Value lhs, Value rhs)
+{
+    Inst inst{op};
+    inst.type = type;
+    inst.ops = {lhs, rhs};
+    return emit(inst);
+}
+
+Value IrBuilder::unary(Op op, Type type, Value value)
+{
+    Inst inst{op};
+    inst.type = type;
+    inst.ops[0] = value;
+    return emit(inst);
+}
+
+Value IrBuilder::compare(Op op, Pred pred, Type type, Value lhs, Value rhs)
+{
+    Inst inst{op, pred};
+    inst.type = type;
+    inst.ops = {lhs, rhs};
+    return emit(inst);
+}
+
+Value IrBuilder::cast(Op op, Value value, Type to)
+{
+    Inst inst{op};
+    inst.type = to;
+    inst.ops[0] = value;
+    return emit(inst);
+}
+
+Value IrBuilder::call(Value func, Type type, const std::vector<Value>& args)
+{
+    Inst inst{Op::CALL};
+    inst.type = type;
+    inst.ops[0] = func;
+    inst.extra_begin = fn->extra.size();
+    inst.extra_count = args.size();
+    fn->extra.insert(fn->extra.end(), args.begin(), args.end());
+    return emit(inst);
+}
+
+Value IrBuilder::phi(Type type, std::initializer_list<std::pair<Value, BlockId>> incoming)
+{
+    Inst inst{Op::PHI};
+    inst.type = type;
+    inst.extra_begin = fn->extra.size();
+    inst.extra_count = incoming.size() * 2;
+    for (auto [value, from] : incoming)
+    {
+        fn->extra.push_back(value);
+        fn->extra.push_back(Value(Value::BLOCK, from));
+    }
+    return emit(inst);
+}
+
+void IrBuilder::br(BlockId target)
+{
+    if (terminated()) return;
+    Inst inst{Op::BR};
+    inst.ops[0] = Value(Value::BLOCK, target);
+    emit(inst);
+    edge(block, target);
+}
+
+void IrBuilder::cond_br(Value condition, BlockId on_true, BlockId on_false)
+{
+    if (terminated()) return;
+    Inst inst{Op::CONDBR};
+    inst.ops = {condition, Value(Value::BLOCK, on_true), Value(Value::BLOCK, on_false)};
+    emit(inst);
+    edge(block, on_true);
+    edge(block, on_false);
+}
+
+void IrBuilder::ret(Type type, Value value)
+{
+    if (terminated()) return;
+    Inst inst{Op::RET};
+    inst.type = type;
+    inst.ops[0] = value;
+    emit(inst);
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+#include "type.h"
+
+// std
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// dcc's own IR
+// A module holds the functions, globals and constants of a program, and a function holds its basic blocks and
+// instructions in contiguous pools, everything refers to everything else by 32-bit handles into those pools
+// Codegen builds it and print_ir turns it into LLVM IR text, so passes can work on it instead of on strings
+
+using BlockId = uint32_t;
+using InstId = uint32_t;
+constexpr uint32_t NO_ID = UINT32_MAX;
+
+// Handle to a value, the kind is in the top bits and the index into the pool of that kind in the rest
+// Instructions, arguments and blocks are indices into the function, constants, globals and functions into the module
+struct Value
+{
+    enum Kind : uint8_t { NONE, INST, ARG, CONST, GLOBAL, FUNC, BLOCK };
+
+    static constexpr uint32_t INDEX_BITS = 29;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+
+    uint32_t bits = 0;
+
+    Value() = default;
+    Value(Kind kind, uint32_t index) : bits(((uint32_t) kind << INDEX_BITS) | index) {}
+
+    Kind kind() const { return (Kind) (bits >> INDEX_BITS); }
+    uint32_t index() const { return bits & INDEX_MASK; }
+    explicit operator bool() const { return bits != 0; }
+    bool operator==(const Value& value) const { return bits == value.bits; }
+    bool operator!=(const Value& value) const { return bits != value.bits; }
+};
+
+enum class Op : uint8_t
+{
+    ALLOCA,
+    LOAD,
+    STORE,
+    GEP,
+    ADD,
+    SUB,
+    MUL,
+    SDIV,
+    UDIV,
+    SREM,
+    UREM,
+    FADD,
+    FSUB,
+    FMUL,
+    FDIV,
+    FREM,
+    XOR,
+    FNEG,
+    ICMP,
+    FCMP,
+    TRUNC,
+    ZEXT,
+    SEXT,
+    FPTRUNC,
+    FPEXT,
+    FPTOSI,
+    FPTOUI,
+    SITOFP,
+    UITOFP,
+    INTTOPTR,
+    PTRTOINT,
+    CALL,
+    PHI,
+    BR,
+    CONDBR,
+    RET
+};
+
+// Comparison predicates of icmp and fcmp
+enum class Pred : uint8_t
+{
+    NONE,
+    EQ,
+    NE,
+    SGT,
+    SGE,
+    SLT,
+    SLE,
+    UGT,
+    UGE,
+    ULT,
+    ULE,
+    OEQ,
+    ONE,
+    OGT,
+    OGE,
+    OLT,
+    OLE,
+    UNE
+};
+
+constexpr bool is_terminator(Op op) { return op == Op::BR || op == Op::CONDBR || op == Op::RET; }
+constexpr bool is_cast(Op op) { return op >= Op::TRUNC && op <= Op::PTRTOINT; }
+
+struct Inst
+{
+    Op op;
+    Pred pred = Pred::NONE;
+    // Alignment printed on allocas, loads and stores, 0 leaves it out
+    uint8_t align = 0;
+
+    // What the op works on: the allocated, loaded or stored type, the operand type of arithmetic and comparisons,
+    // the destination type of casts, the element type of geps, and the return type of calls, phis and rets
+    Type type = {TypeKind::NULLTP, 0};
+
+    // The block the instruction is in, and its neighbours there
+    BlockId block = NO_ID;
+    InstId prev = NO_ID;
+    InstId next = NO_ID;
+
+    // Operands, in the order they are printed, a store is (value, pointer) and a conditional branch (condition, true, false)
+    std::array<Value, 3> ops{};
+
+    // Arguments of calls and (value, block) pairs of phis, a range of Function::extra
+    uint32_t extra_begin = 0;
+    uint32_t extra_count = 0;
+};
+
+struct Block
+{
+    // Loops name their blocks, every other block is numbered like a temp when it is printed
+    std::string_view name;
+    uint32_t name_id = 0;
+
+    // First and last instruction, NO_ID if the block is empty
+    InstId first = NO_ID;
+    InstId last = NO_ID;
+
+    std::vector<BlockId> preds;
+    std::vector<BlockId> succs;
+};
+
+struct Function
+{
+    std::string_view name;
+    // Return type
+    Type type = {TypeKind::NULLTP, 0};
+    std::vector<Type> args;
+    bool defined = false;
+
+    std::vector<Inst> insts;
+    std::vector<Block> blocks;
+    // Blocks in the order they are printed, the first one is the entry
+    std::vector<BlockId> layout;
+    std::vector<Value> extra;
+
+    // The type of the value an instruction makes, NULLTP if it doesn't make one
+    Type result_type(const Inst& inst) const;
+
+    // The last instruction of the block if it is a terminator
+    const Inst* terminator(BlockId block) const;
+
+    // Adds an instruction to the end of a block
+    InstId append(BlockId block, const Inst& inst);
+    // Adds an instruction to a block in front of before, or at the end if before is NO_ID
+    InstId insert(BlockId block, InstId before, const Inst& inst);
+    // Unlinks an instruction from its block, it stays in the pool but isn't part of the function any more
+    void remove(InstId inst);
+
+    // Calls f on every operand of inst, the extra ones of calls and phis included
+    template <typename F>
+    void for_each_operand(Inst& inst, F&& f)
+    {
+        for (Value& op : inst.ops)
+        {
+            if (op) f(op);
+        }
+        for (uint32_t i = 0; i < inst.extra_count; i++) f(extra[inst.extra_begin + i]);
+    }
+};
+
+struct Constant
+{
+    Type type;
+    LiteralValue value;
+};
+
+struct Global
+{
+    std::string_view name;
+    Type type = {TypeKind::NULLTP, 0};
+    // The initial value, a constant
+    Value init = {};
+};
+
+struct Module
+{
+    std::vector<Function> functions;
+    std::vector<Global> globals;
+    // Constants are interned, so two constants are the same value if and only if their handles are equal
+    std::vector<Constant> consts;
+
+    // Globals and functions in the order they are printed
+    std::vector<Value> order;
+
+    Value constant(Type type, LiteralValue value);
+    Type type_of(const Function& fn, Value value) const;
+private:
+    struct ConstKey
+    {
+        uint64_t bits;
+        uint32_t type;
+        bool operator==(const ConstKey&) const = default;
+    };
+    struct ConstHash { size_t operator()(const ConstKey& key) const { return key.bits * 31 + key.type; } };
+    std::unordered_map<ConstKey, uint32_t, ConstHash> const_ids;
+};
+
+// The type of a pointer to type
+constexpr Type pointer_to(Type type)
+{
+    type.num_pointers++;
+    type.is_const = false;
+    return type;
+}
+
+// Appends instructions to a function, keeping track of the block they go into and the edges between blocks
+class IrBuilder
+{
+private:
+    Module* module = nullptr;
+    Function* fn = nullptr;
+    BlockId block = NO_ID;
+    // The last alloca of the entry block, the next one goes after it
+    InstId last_alloca = NO_ID;
+
+    Value emit(const Inst& inst);
+    void edge(BlockId from, BlockId to);
+public:
+    IrBuilder(Module& module) : module(&module) {}
+
+    // Starts building the body of a function, in its entry block
+    // The module's function pool can't grow while a function is built, since the builder keeps a pointer into it
+    void begin_function(Function& fn);
+
+    Module& get_module() { return *module; }
+    Function& function() { return *fn; }
+
+    // Makes a block, it isn't part of the function's layout until it is placed
+    BlockId create_block(std::string_view name = {}, uint32_t name_id = 0);
+    // Lays block out after the ones placed so far and moves to it
+    void place(BlockId block);
+    BlockId current() const { return block; }
+    // If the current block already ends in a terminator (the rest of it would be unreachable)
+    bool terminated() const { return fn->terminator(block); }
+
+    Value constant(Type type, LiteralValue value) { return module->constant(type, value); }
+    Value constant(Type type, int64_t value);
+    // Zero (or null) of type
+    Value zero(Type type);
+
+    // Allocas all go at the start of the entry block wherever they are made, so they are allocated once per call
+    // (an alloca in a loop would take more stack every iteration)
+    Value stack_slot(Type type);
+    Value load(Type type, Value ptr, uint8_t align);
+    void store(Type type, Value value, Value ptr);
+    Value gep(Type elem, Value ptr, Value index);
+    Value binary(Op op, Type type, Value lhs, Value rhs);
+    Value unary(Op op, Type type, Value value);
+    Value compare(Op op, Pred pred, Type type, Value lhs, Value rhs);
+    Value cast(Op op, Value value, Type to);
+    Value call(Value func, Type type, const std::vector<Value>& args);
+    Value phi(Type type, std::initializer_list<std::pair<Value, BlockId>> incoming);
+
+    // Terminators do nothing if the block is already terminated
+    void br(BlockId target);
+    void cond_br(Value condition, BlockId on_true, BlockId on_false);
+    void ret(Type type, Value value);
+};
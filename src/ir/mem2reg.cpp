@@ -0,0 +1,306 @@
+#include "passes.h"
+#include "cfg.h"
+
+// std
+#include <utility>
+#include <vector>
+
+// Promotion follows Cytron et al.: phis go at the iterated dominance frontier of the blocks that store to a variable,
+// pruned to the blocks the variable is live into, and then loads are renamed to the value that reaches them in a
+// walk of the dominator tree
+
+namespace
+{
+
+struct Promoter
+{
+    Module& module;
+    Function& fn;
+
+    // The variable of every promoted alloca, NO_ID for everything else
+    std::vector<uint32_t> var_of;
+    std::vector<InstId> allocas;
+
+    // Blocks that store to each variable, and blocks that load it before storing to it
+    std::vector<std::vector<BlockId>> defs;
+    std::vector<std::vector<BlockId>> uses;
+
+    // The phis inserted into each block, and the variable each is for
+    std::vector<std::vector<std::pair<uint32_t, InstId>>> block_phis;
+
+    // The value each variable has at the point of the walk, and what to restore when the walk leaves a block
+    std::vector<Value> current;
+    std::vector<std::pair<uint32_t, Value>> undo;
+    // What every removed load is replaced with
+    std::vector<Value> replace;
+
+    Promoter(Module& module, Function& fn) : module(module), fn(fn) {}
+
+    // The variable whose alloca value is, if it is promoted
+    uint32_t var(Value value) const
+    {
+        if (value.kind() != Value::INST || value.index() >= var_of.size()) return NO_ID;
+        return var_of[value.index()];
+    }
+
+    // An alloca can be promoted if it is only the pointer of loads and stores of its own type
+    void find_variables()
+    {
+        var_of.assign(fn.insts.size(), NO_ID);
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next)
+            {
+                if (fn.insts[i].op == Op::ALLOCA) var_of[i] = 0;
+            }
+        }
+
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next)
+            {
+                Inst& inst = fn.insts[i];
+                for (size_t op = 0; op < inst.ops.size(); op++)
+                {
+                    uint32_t v = var(inst.ops[op]);
+                    if (v == NO_ID) continue;
+                    const Type& type = fn.insts[inst.ops[op].index()].type;
+                    bool is_pointer = (inst.op == Op::LOAD && op == 0) || (inst.op == Op::STORE && op == 1);
+                    if (!is_pointer || inst.type != type) var_of[inst.ops[op].index()] = NO_ID;
+                }
+                for (uint32_t e = 0; e < inst.extra_count; e++)
+                {
+                    Value value = fn.extra[inst.extra_begin + e];
+                    if (var(value) != NO_ID) var_of[value.index()] = NO_ID;
+                }
+            }
+        }
+
+        for (InstId i = 0; i < var_of.size(); i++)
+        {
+            if (var_of[i] == NO_ID) continue;
+            var_of[i] = allocas.size();
+            allocas.push_back(i);
+        }
+    }
+
+    void find_defs_and_uses()
+    {
+        defs.resize(allocas.size());
+        uses.resize(allocas.size());
+        // The last block each variable was stored to or loaded from in, blocks are scanned one at a time
+        std::vector<BlockId> stored_in(allocas.size(), NO_ID);
+        std::vector<BlockId> loaded_in(allocas.size(), NO_ID);
+
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next)
+            {
+                const Inst& inst = fn.insts[i];
+                if (inst.op == Op::LOAD)
+                {
+                    uint32_t v = var(inst.ops[0]);
+                    if (v == NO_ID || stored_in[v] == block || loaded_in[v] == block) continue;
+                    loaded_in[v] = block;
+                    uses[v].push_back(block);
+                }
+                else if (inst.op == Op::STORE)
+                {
+                    uint32_t v = var(inst.ops[1]);
+                    if (v == NO_ID || stored_in[v] == block) continue;
+                    stored_in[v] = block;
+                    defs[v].push_back(block);
+                }
+            }
+        }
+    }
+
+    void insert_phis(const DomTree& dom)
+    {
+        std::vector<std::vector<BlockId>> frontier = dom.frontiers(fn);
+        block_phis.resize(fn.blocks.size());
+
+        // Marks of which variable last had each block as a def, live in, or with a phi, so they are never cleared
+        std::vector<uint32_t> def_mark(fn.blocks.size(), NO_ID);
+        std::vector<uint32_t> live_mark(fn.blocks.size(), NO_ID);
+        std::vector<uint32_t> phi_mark(fn.blocks.size(), NO_ID);
+        std::vector<BlockId> worklist;
+
+        for (uint32_t v = 0; v < allocas.size(); v++)
+        {
+            for (BlockId block : defs[v]) def_mark[block] = v;
+
+            // The variable is live into a block that loads it first, and into the blocks before that don't store to it
+            worklist = uses[v];
+            for (BlockId block : worklist) live_mark[block] = v;
+            while (!worklist.empty())
+            {
+                BlockId block = worklist.back();
+                worklist.pop_back();
+                for (BlockId pred : fn.blocks[block].preds)
+                {
+                    if (live_mark[pred] == v || def_mark[pred] == v) continue;
+                    live_mark[pred] = v;
+                    worklist.push_back(pred);
+                }
+            }
+
+            worklist = defs[v];
+            while (!worklist.empty())
+            {
+                BlockId block = worklist.back();
+                worklist.pop_back();
+                for (BlockId join : frontier[block])
+                {
+                    if (phi_mark[join] == v || live_mark[join] != v) continue;
+                    phi_mark[join] = v;
+                    block_phis[join].push_back({v, add_phi(join, fn.insts[allocas[v]].type)});
+                    // The phi is a store to the variable too
+                    if (def_mark[join] != v) worklist.push_back(join);
+                }
+            }
+        }
+    }
+
+    // A phi at the start of block with an incoming value for every predecessor, filled in by the walk
+    InstId add_phi(BlockId block, Type type)
+    {
+        Inst phi{Op::PHI};
+        phi.type = type;
+        phi.extra_begin = fn.extra.size();
+        phi.extra_count = fn.blocks[block].preds.size() * 2;
+        for (BlockId pred : fn.blocks[block].preds)
+        {
+            fn.extra.push_back({});
+            fn.extra.push_back(Value(Value::BLOCK, pred));
+        }
+        return fn.insert(block, fn.blocks[block].first, phi);
+    }
+
+    Value resolve(Value value) const
+    {
+        while (value.kind() == Value::INST && value.index() < replace.size() && replace[value.index()]) value = replace[value.index()];
+        return value;
+    }
+
+    // The value a variable has, a load of a variable that was never stored to reads zero
+    Value value_of(uint32_t v)
+    {
+        if (current[v]) return current[v];
+        return module.constant(fn.insts[allocas[v]].type, LiteralValue{});
+    }
+
+    void define(uint32_t v, Value value)
+    {
+        undo.push_back({v, current[v]});
+        current[v] = value;
+    }
+
+    void restore(size_t mark)
+    {
+        while (undo.size() > mark)
+        {
+            current[undo.back().first] = undo.back().second;
+            undo.pop_back();
+        }
+    }
+
+    // Removes the loads, stores and allocas of promoted variables from a block, and gives its successors' phis
+    // the values the variables have at its end
+    void rename(BlockId block)
+    {
+        for (auto [v, phi] : block_phis[block]) define(v, Value(Value::INST, phi));
+
+        InstId next;
+        for (InstId i = fn.blocks[block].first; i != NO_ID; i = next)
+        {
+            next = fn.insts[i].next;
+            Inst& inst = fn.insts[i];
+            if (inst.op == Op::ALLOCA && var(Value(Value::INST, i)) != NO_ID) fn.remove(i);
+            else if (inst.op == Op::LOAD && var(inst.ops[0]) != NO_ID)
+            {
+                replace[i] = value_of(var(inst.ops[0]));
+                fn.remove(i);
+            }
+            else if (inst.op == Op::STORE && var(inst.ops[1]) != NO_ID)
+            {
+                define(var(inst.ops[1]), resolve(inst.ops[0]));
+                fn.remove(i);
+            }
+        }
+
+        for (BlockId succ : fn.blocks[block].succs)
+        {
+            for (auto [v, phi] : block_phis[succ])
+            {
+                const Inst& inst = fn.insts[phi];
+                for (uint32_t e = 0; e < inst.extra_count; e += 2)
+                {
+                    if (fn.extra[inst.extra_begin + e + 1] == Value(Value::BLOCK, block)) fn.extra[inst.extra_begin + e] = value_of(v);
+                }
+            }
+        }
+    }
+
+    void rename_all(const DomTree& dom)
+    {
+        current.assign(allocas.size(), {});
+        replace.assign(fn.insts.size(), {});
+
+        // Walk the tree with an explicit stack, a variable's value in a block is the one at the end of its dominator
+        struct Visit { BlockId block; uint32_t next_child; size_t mark; };
+        std::vector<Visit> stack;
+        BlockId entry = dom.rpo.front();
+        stack.push_back({entry, 0, undo.size()});
+        rename(entry);
+        while (!stack.empty())
+        {
+            Visit& top = stack.back();
+            auto children = dom.children(top.block);
+            if (top.next_child < children.size())
+            {
+                BlockId child = children[top.next_child++];
+                stack.push_back({child, 0, undo.size()});
+                rename(child);
+            }
+            else
+            {
+                restore(top.mark);
+                stack.pop_back();
+            }
+        }
+
+        // Unreachable blocks still have to be valid, every variable reads zero in them
+        for (BlockId block : fn.layout)
+        {
+            if (dom.reachable(block)) continue;
+            size_t mark = undo.size();
+            rename(block);
+            restore(mark);
+        }
+
+        // Uses of the removed loads that weren't dominated by them, like the incoming values of phis, are resolved last
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next)
+            {
+                fn.for_each_operand(fn.insts[i], [&](Value& value) { value = resolve(value); });
+            }
+        }
+    }
+};
+
+}
+
+void promote_allocas(Module& module, Function& fn)
+{
+    Promoter promoter(module, fn);
+    promoter.find_variables();
+    if (promoter.allocas.empty()) return;
+
+    DomTree dom(fn);
+    promoter.find_defs_and_uses();
+    promoter.insert_phis(dom);
+    promoter.var_of.resize(fn.insts.size(), NO_ID);
+    promoter.rename_all(dom);
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#include "passes.h"
+
+void optimize(Module& module)
+{
+    for (Function& fn : module.functions)
+    {
+        if (!fn.defined) continue;
+        promote_allocas(module, fn);
+        number_values(module, fn);
+        eliminate_dead_code(module, fn);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "ir.h"
+
+// Passes over the IR, dcc's output goes straight to llc so what isn't done here isn't done at all
+// Each pass works on one defined function at a time
+
+// Turns locals that are only loaded and stored (their address is never taken) into SSA values, with phis where
+// control flow merges, so they stop going through memory
+void promote_allocas(Module& module, Function& fn);
+
+// Replaces arithmetic, comparisons, casts and geps that a dominating instruction already computed with that
+// instruction, and loads of pointers whose value is known from an earlier load or store, when nothing in between
+// can have changed it
+void number_values(Module& module, Function& fn);
+
+// Removes unreachable blocks and branches on known conditions, then every instruction whose result is never used
+// by something with a side effect, and the stores to allocas that are never read
+void eliminate_dead_code(Module& module, Function& fn);
+
+// Runs every pass on every defined function of the module
+void optimize(Module& module);
\ No newline at end of file
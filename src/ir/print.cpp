@@ -0,0 +1,241 @@
+#include "print.h"
+#include "writer.h"
+
+// std
+#include <array>
+#include <string_view>
+#include <vector>
+
+// Spelling of every op and predicate, in the order of their enums
+constexpr std::array<std::string_view, (size_t) Op::RET + 1> op_names{{
+    "alloca", "load", "store", "getelementptr inbounds",
+    "add", "sub", "mul", "sdiv", "udiv", "srem", "urem", "fadd", "fsub", "fmul", "fdiv", "frem", "xor", "fneg",
+    "icmp", "fcmp",
+    "trunc", "zext", "sext", "fptrunc", "fpext", "fptosi", "fptoui", "sitofp", "uitofp", "inttoptr", "ptrtoint",
+    "call", "phi", "br", "br", "ret",
+}};
+
+constexpr std::array<std::string_view, (size_t) Pred::UNE + 1> pred_names{{
+    "", "eq", "ne", "sgt", "sge", "slt", "sle", "ugt", "uge", "ult", "ule", "oeq", "one", "ogt", "oge", "olt", "ole", "une",
+}};
+
+class Printer
+{
+private:
+    const Module& module;
+    IrWriter& out;
+
+    // The function being printed, and the number of every value and unnamed block in it
+    const Function* fn = nullptr;
+    std::vector<uint32_t> inst_nums;
+    std::vector<uint32_t> block_nums;
+
+    // Unnamed values have to be numbered in the order they are defined, arguments first and then the entry block
+    void number()
+    {
+        inst_nums.assign(fn->insts.size(), NO_ID);
+        block_nums.assign(fn->blocks.size(), NO_ID);
+
+        uint32_t next = fn->args.size();
+        for (BlockId block : fn->layout)
+        {
+            if (fn->blocks[block].name.empty()) block_nums[block] = next++;
+            for (InstId i = fn->blocks[block].first; i != NO_ID; i = fn->insts[i].next)
+            {
+                if (fn->result_type(fn->insts[i])) inst_nums[i] = next++;
+            }
+        }
+    }
+
+    void label(BlockId block)
+    {
+        const Block& b = fn->blocks[block];
+        if (b.name.empty()) out.print(block_nums[block]);
+        else out.print(b.name, b.name_id);
+    }
+
+    void constant(const Constant& c)
+    {
+        if (c.type.num_pointers)
+        {
+            if (c.value.i) out.print(c.value.i);
+            else out.print("null");
+        }
+        else if (c.type.t_kind == TypeKind::BOOL) out.print(c.value.i ? "true" : "false");
+        else if (c.type.t_kind == TypeKind::FLOAT) out.print(literal_to_string(c.value, c.type));
+        else if (c.type.t_kind == TypeKind::UNSIGNED) out.print((uint64_t) c.value.i);
+        else out.print(c.value.i);
+    }
+
+    void value(Value value)
+    {
+        switch (value.kind())
+        {
+            case Value::INST: out.print('%', inst_nums[value.index()]); break;
+            case Value::ARG: out.print('%', value.index()); break;
+            case Value::CONST: constant(module.consts[value.index()]); break;
+            case Value::GLOBAL: out.print('@', module.globals[value.index()].name); break;
+            case Value::FUNC: out.print('@', module.functions[value.index()].name); break;
+            case Value::BLOCK: out.print('%'); label(value.index()); break;
+            case Value::NONE: break;
+        }
+    }
+
+    // A value with its type in front of it
+    void typed(Value value)
+    {
+        out.print(type_to_string(module.type_of(*fn, value)), ' ');
+        this->value(value);
+    }
+
+    void inst(const Inst& inst, InstId id)
+    {
+        out.print("    ");
+        if (inst_nums[id] != NO_ID) out.print('%', inst_nums[id], " = ");
+        out.print(op_names[(size_t) inst.op]);
+
+        switch (inst.op)
+        {
+            case Op::ALLOCA:
+                out.print(' ', type_to_string(inst.type));
+                break;
+            case Op::LOAD:
+                out.print(' ', type_to_string(inst.type), ", ");
+                typed(inst.ops[0]);
+                break;
+            case Op::STORE:
+                out.print(' ', type_to_string(inst.type), ' ');
+                value(inst.ops[0]);
+                out.print(", ");
+                typed(inst.ops[1]);
+                break;
+            case Op::GEP:
+                out.print(' ', type_to_string(inst.type), ", ");
+                typed(inst.ops[0]);
+                out.print(", ");
+                typed(inst.ops[1]);
+                break;
+            case Op::ICMP:
+            case Op::FCMP:
+                out.print(' ', pred_names[(size_t) inst.pred], ' ', type_to_string(inst.type), ' ');
+                value(inst.ops[0]);
+                out.print(", ");
+                value(inst.ops[1]);
+                break;
+            case Op::FNEG:
+                out.print(' ', type_to_string(inst.type), ' ');
+                value(inst.ops[0]);
+                break;
+            case Op::CALL:
+                out.print(' ', type_to_string(inst.type), ' ');
+                value(inst.ops[0]);
+                out.print('(');
+                for (uint32_t i = 0; i < inst.extra_count; i++)
+                {
+                    if (i) out.print(", ");
+                    typed(fn->extra[inst.extra_begin + i]);
+                }
+                out.print(')');
+                break;
+            case Op::PHI:
+                out.print(' ', type_to_string(inst.type));
+                for (uint32_t i = 0; i < inst.extra_count; i += 2)
+                {
+                    out.print(i ? ", [ " : " [ ");
+                    value(fn->extra[inst.extra_begin + i]);
+                    out.print(", ");
+                    value(fn->extra[inst.extra_begin + i + 1]);
+                    out.print(" ]");
+                }
+                break;
+            case Op::BR:
+                out.print(" label ");
+                value(inst.ops[0]);
+                out.print('\n');
+                break;
+            case Op::CONDBR:
+                out.print(' ');
+                typed(inst.ops[0]);
+                out.print(", label ");
+                value(inst.ops[1]);
+                out.print(", label ");
+                value(inst.ops[2]);
+                out.print('\n');
+                break;
+            case Op::RET:
+                out.print(' ', type_to_string(inst.type), ' ');
+                value(inst.ops[0]);
+                break;
+            default:
+                if (is_cast(inst.op))
+                {
+                    out.print(' ');
+                    typed(inst.ops[0]);
+                    out.print(" to ", type_to_string(inst.type));
+                }
+                else
+                {
+                    out.print(' ', type_to_string(inst.type), ' ');
+                    value(inst.ops[0]);
+                    out.print(", ");
+                    value(inst.ops[1]);
+                }
+                break;
+        }
+
+        if (inst.align) out.print(", align ", inst.align);
+        out.print('\n');
+    }
+public:
+    Printer(const Module& module, IrWriter& out) : module(module), out(out) {}
+
+    void function(const Function& fn)
+    {
+        this->fn = &fn;
+
+        if (!fn.defined)
+        {
+            out.print("declare ", type_to_string(fn.type), " @", fn.name, '(');
+            for (size_t i = 0; i < fn.args.size(); i++) out.print(i ? ", " : "", type_to_string(fn.args[i]));
+            out.print(")\n\n");
+            return;
+        }
+
+        number();
+        out.print("define dso_local ", type_to_string(fn.type), " @", fn.name, '(');
+        for (size_t i = 0; i < fn.args.size(); i++) out.print(i ? ", " : "", type_to_string(fn.args[i]), " %", i);
+        out.print(") {\n");
+
+        for (BlockId block : fn.layout)
+        {
+            // The entry block has no label
+            if (block != fn.layout.front())
+            {
+                label(block);
+                out.print(":\n");
+            }
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next) inst(fn.insts[i], i);
+        }
+
+        out.print("}\n\n");
+    }
+
+    void global(const Global& global)
+    {
+        out.print('@', global.name, " = dso_local global ", type_to_string(global.type), ' ');
+        value(global.init);
+        out.print(", align ", global.type.size_of(), "\n\n");
+    }
+};
+
+std::string print_ir(const Module& module)
+{
+    IrWriter out;
+    Printer printer(module, out);
+    for (Value item : module.order)
+    {
+        if (item.kind() == Value::FUNC) printer.function(module.functions[item.index()]);
+        else printer.global(module.globals[item.index()]);
+    }
+    return out.str();
+}
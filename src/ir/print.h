@@ -0,0 +1,9 @@
+#pragma once
+
+#include "ir.h"
+
+// std
+#include <string>
+
+// Prints a module as LLVM IR text
+std::string print_ir(const Module& module);
@@ -0,0 +1,75 @@
+#pragma once
+
+// std
+#include <algorithm>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Where print_ir writes the IR text to, one output buffer made of chunks
+// A full chunk is kept as it is and a bigger one is started, so the text written so far is never copied to grow it
+class IrWriter
+{
+private:
+    // Chunks start small so a small module doesn't take much memory, and double up to the largest size
+    static constexpr size_t FIRST_CHUNK = 256;
+    static constexpr size_t MAX_CHUNK = 64 << 10;
+
+    std::vector<std::string> chunks;
+    size_t next_capacity = FIRST_CHUNK;
+    size_t bytes = 0;
+
+    std::string& reserve(size_t n)
+    {
+        if (chunks.empty() || chunks.back().capacity() - chunks.back().size() < n)
+        {
+            chunks.emplace_back().reserve(std::max(next_capacity, n));
+            next_capacity = std::min(next_capacity * 2, MAX_CHUNK);
+        }
+        bytes += n;
+        return chunks.back();
+    }
+
+    static std::string_view format(std::string_view str, char*) { return str; }
+    static std::string_view format(char c, char* buf) { *buf = c; return std::string_view(buf, 1); }
+
+    template <typename T> requires std::is_integral_v<T>
+    static std::string_view format(T value, char* buf)
+    {
+        return std::string_view(buf, std::to_chars(buf, buf + 24, value).ptr - buf);
+    }
+public:
+    // Appends every argument, integers are printed with to_chars
+    template <typename... Args>
+    void print(const Args&... args)
+    {
+        char bufs[sizeof...(Args)][24];
+        size_t i = 0;
+        std::string_view strs[] = {format(args, bufs[i++])...};
+
+        size_t n = 0;
+        for (std::string_view str : strs) n += str.size();
+        std::string& chunk = reserve(n);
+        for (std::string_view str : strs) chunk.append(str);
+    }
+
+    size_t size() const { return bytes; }
+
+    // All of the text in one string
+    std::string str() const
+    {
+        std::string out;
+        out.reserve(bytes);
+        for (const std::string& chunk : chunks) out += chunk;
+        return out;
+    }
+
+    void clear()
+    {
+        chunks.clear();
+        next_capacity = FIRST_CHUNK;
+        bytes = 0;
+    }
+};
@@ -0,0 +1,88 @@
+#include "intern.h"
+
+#include <cstring>
+
+// Spellings are copied into blocks that never move, so the views handed out stay valid
+constexpr size_t NAME_BLOCK_SIZE = 1 << 16;
+
+// Open addressing table of symbol ids, the hash is kept next to the id so most probes don't touch the names
+struct InternSlot
+{
+    uint32_t hash;
+    SymbolId sym = NO_SYMBOL;
+};
+
+static std::vector<std::unique_ptr<char[]>> name_blocks;
+static size_t name_block_used = NAME_BLOCK_SIZE;
+static std::vector<std::string_view> names;
+static std::vector<InternSlot> slots(1024);
+
+static uint32_t hash_name(std::string_view str)
+{
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (char c : str) h = (h ^ (uint8_t) c) * 16777619u;
+    return h;
+}
+
+static std::string_view store_name(std::string_view str)
+{
+    if (name_block_used + str.size() + 1 > NAME_BLOCK_SIZE)
+    {
+        name_blocks.emplace_back(new char[str.size() + 1 > NAME_BLOCK_SIZE ? str.size() + 1 : NAME_BLOCK_SIZE]);
+        name_block_used = 0;
+    }
+
+    char* dst = name_blocks.back().get() + name_block_used;
+    memcpy(dst, str.data(), str.size());
+    dst[str.size()] = '\0';
+    name_block_used += str.size() + 1;
+
+    return std::string_view(dst, str.size());
+}
+
+static void grow()
+{
+    std::vector<InternSlot> old(slots.size() * 2);
+    old.swap(slots);
+
+    size_t mask = slots.size() - 1;
+    for (const auto& slot : old)
+    {
+        if (slot.sym == NO_SYMBOL) continue;
+        size_t i = slot.hash & mask;
+        while (slots[i].sym != NO_SYMBOL) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
+
+SymbolId intern(std::string_view str)
+{
+    uint32_t h = hash_name(str);
+    size_t mask = slots.size() - 1;
+
+    size_t i = h & mask;
+    for (; slots[i].sym != NO_SYMBOL; i = (i + 1) & mask)
+    {
+        if (slots[i].hash == h && names[slots[i].sym] == str) return slots[i].sym;
+    }
+
+    SymbolId sym = names.size();
+    names.push_back(store_name(str));
+    slots[i] = {h, sym};
+
+    // Keep the table at most half full
+    if (names.size() * 2 > slots.size()) grow();
+
+    return sym;
+}
+
+std::string_view symbol_name(SymbolId sym)
+{
+    return names[sym];
+}
+
+size_t symbol_count()
+{
+    return names.size();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Identifiers are interned when they are lexed, and everything after the lexer refers to them by symbol id
+using SymbolId = uint32_t;
+constexpr SymbolId NO_SYMBOL = UINT32_MAX;
+
+// Returns the id for str, giving it the next id if it hasn't been seen before
+SymbolId intern(std::string_view str);
+
+// The spelling of a symbol, the data is null terminated so it can go straight into error messages
+std::string_view symbol_name(SymbolId sym);
+
+// Number of symbols handed out, ids are dense so this is one past the highest id
+size_t symbol_count();
+
+// A table from symbols to T indexed directly by the symbol id, entries don't move once inserted
+template <typename T>
+class SymbolTable
+{
+private:
+    std::vector<std::unique_ptr<T>> slots;
+public:
+    bool contains(SymbolId sym) const { return sym < slots.size() && slots[sym]; }
+    T* find(SymbolId sym) const { return contains(sym) ? slots[sym].get() : nullptr; }
+
+    // Inserts a default T if sym isn't in the table yet, like std::unordered_map
+    T& operator[](SymbolId sym)
+    {
+        if (sym >= slots.size()) slots.resize(symbol_count() > sym ? symbol_count() : sym + 1);
+        if (!slots[sym]) slots[sym] = std::make_unique<T>();
+        return *slots[sym];
+    }
+
+    void clear() { slots.clear(); }
+};
+
+// A table from symbols to T with nested scopes, each symbol maps straight to its innermost binding
+// Declaring saves the binding it shadows on an undo log and leaving a scope puts those back, so a lookup costs the same
+// however deep the nesting is and a scope only costs the declarations made in it
+template <typename T>
+class ScopedTable
+{
+private:
+    struct Binding
+    {
+        T value{};
+        // Depth of the scope the binding was made in, 0 if the symbol isn't bound
+        uint32_t depth = 0;
+    };
+
+    std::vector<Binding> bindings;
+    std::vector<std::pair<SymbolId, Binding>> undo;
+    // Size of the undo log when each open scope was entered
+    std::vector<size_t> scopes;
+public:
+    // Number of open scopes, 0 is the global scope (nothing can be declared in it)
+    size_t depth() const { return scopes.size(); }
+
+    void enter() { scopes.push_back(undo.size()); }
+    void leave()
+    {
+        for (size_t mark = scopes.back(); undo.size() > mark; undo.pop_back())
+        {
+            bindings[undo.back().first] = std::move(undo.back().second);
+        }
+        scopes.pop_back();
+    }
+
+    T* find(SymbolId sym) { return sym < bindings.size() && bindings[sym].depth ? &bindings[sym].value : nullptr; }
+
+    // If sym was declared in the innermost scope
+    bool declared_here(SymbolId sym) const { return sym < bindings.size() && bindings[sym].depth && bindings[sym].depth == depth(); }
+
+    T& declare(SymbolId sym, T value)
+    {
+        if (sym >= bindings.size()) bindings.resize(symbol_count() > sym ? symbol_count() : sym + 1);
+        undo.emplace_back(sym, std::move(bindings[sym]));
+        bindings[sym] = {std::move(value), (uint32_t) depth()};
+        return bindings[sym].value;
+    }
+
+    void clear()
+    {
+        bindings.clear();
+        undo.clear();
+        scopes.clear();
+    }
+};
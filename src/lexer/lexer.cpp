@@ -1,156 +1,253 @@
 #include "lexer.h"
+#include "simd.h"
 
 #include "error/error.h"
 #include "util.h"
 
 // std
-#include <iostream>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <string>
-#include <sstream>
-#include <unordered_map>
+#include <string_view>
 #include <utility>
-#include <algorithm>
-#include <string.h>
-
-// Constants used to see if a string fits within a group
-#define DIGITS "0123456789"
-#define ALPHABET "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_"
-#define ALPHANUMERIC "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_"
-
-// Lexer character map (so that it is easier to tokenize characters)
-std::unordered_map<std::string, Token> map({
-    {"{", Token(TokenType::OBRACKET)}, 
-    {"}", Token(TokenType::CBRACKET)}, 
-    {"(", Token(TokenType::OPAREN)}, 
-    {")", Token(TokenType::CPAREN)}, 
-    {";", Token(TokenType::SEMI)}, 
-    {",", Token(TokenType::COMMA)}, 
-    {"!", Token(TokenType::NOT)}, 
-    {"~", Token(TokenType::BITCOMPL)}, 
-    {"-", Token(TokenType::DASH)}, 
-    {"+", Token(TokenType::ADD)}, 
-    {"++", Token(TokenType::INC)},
-    {"--", Token(TokenType::DEC)}, 
-    {"*", Token(TokenType::MUL)}, 
-    {"/", Token(TokenType::DIV)}, 
-    {"%", Token(TokenType::MOD)},
-    {"&", Token(TokenType::ADDR)}, 
-    {"&&", Token(TokenType::AND)}, 
-    {"||", Token(TokenType::OR)}, 
-    {"==", Token(TokenType::EQ)}, 
-    {"!=", Token(TokenType::NOTEQ)}, 
-    {"<", Token(TokenType::LESS)}, 
-    {"<=", Token(TokenType::LESSEQ)}, 
-    {">", Token(TokenType::GREATER)}, 
-    {">=", Token(TokenType::GREATEREQ)},
-    {"?", Token(TokenType::TERN)},
-    {":", Token(TokenType::COLON)}, 
-    {"const", Token(TokenType::CONST)},
-    {"unsigned", Token(TokenType::UNSIGNED)},
-    {"long", Token(TokenType::TLONG)},
-    {"int", Token(TokenType::TINT)},
-    {"short", Token(TokenType::TSHORT)},
-    {"char", Token(TokenType::TCHAR)},
-    {"double", Token(TokenType::TDOUBLE)}, 
-    {"float", Token(TokenType::TFLOAT)}, 
-    {"return", Token(TokenType::RET)}, 
-    {"if", Token(TokenType::IF)}, 
-    {"else", Token(TokenType::ELSE)}, 
-    {"for", Token(TokenType::FOR)}, 
-    {"while", Token(TokenType::WHILE)}, 
-    {"do", Token(TokenType::DO)}, 
-    {"break", Token(TokenType::BREAK)}, 
-    {"continue", Token(TokenType::CONTINUE)}, 
-    {"=", Token(TokenType::ASSIGN)}, 
-    {"[integer]", Token(TokenType::INTV)}, 
-    {"[float]", Token(TokenType::FLOATV)},
-    {"[alphan]", Token(TokenType::IDENT)}
-});
-
-// The lexer function, which takes in a string (the data to be scanned)
-Tokenizer scan(std::string data)
+
+// Spelling of every operator, the DFA below is built from this
+struct Spelling
+{
+    std::string_view str;
+    TokenType type;
+};
+
+constexpr std::array<Spelling, 27> operators{{
+    {"{", TokenType::OBRACKET},
+    {"}", TokenType::CBRACKET},
+    {"(", TokenType::OPAREN},
+    {")", TokenType::CPAREN},
+    {";", TokenType::SEMI},
+    {",", TokenType::COMMA},
+    {"!", TokenType::NOT},
+    {"~", TokenType::BITCOMPL},
+    {"-", TokenType::DASH},
+    {"+", TokenType::ADD},
+    {"++", TokenType::INC},
+    {"--", TokenType::DEC},
+    {"*", TokenType::MUL},
+    {"/", TokenType::DIV},
+    {"%", TokenType::MOD},
+    {"&", TokenType::ADDR},
+    {"&&", TokenType::AND},
+    {"||", TokenType::OR},
+    {"==", TokenType::EQ},
+    {"!=", TokenType::NOTEQ},
+    {"<", TokenType::LESS},
+    {"<=", TokenType::LESSEQ},
+    {">", TokenType::GREATER},
+    {">=", TokenType::GREATEREQ},
+    {"?", TokenType::TERN},
+    {":", TokenType::COLON},
+    {"=", TokenType::ASSIGN},
+}};
+
+constexpr std::array<Spelling, 16> keywords{{
+    {"const", TokenType::CONST},
+    {"unsigned", TokenType::UNSIGNED},
+    {"long", TokenType::TLONG},
+    {"int", TokenType::TINT},
+    {"short", TokenType::TSHORT},
+    {"char", TokenType::TCHAR},
+    {"double", TokenType::TDOUBLE},
+    {"float", TokenType::TFLOAT},
+    {"return", TokenType::RET},
+    {"if", TokenType::IF},
+    {"else", TokenType::ELSE},
+    {"for", TokenType::FOR},
+    {"while", TokenType::WHILE},
+    {"do", TokenType::DO},
+    {"break", TokenType::BREAK},
+    {"continue", TokenType::CONTINUE},
+}};
+
+// Maximal munch DFA for operators, state 0 is the start state and a next state of 0 means there is no transition
+constexpr size_t OPERATOR_STATES = 32;
+
+struct OperatorDFA
 {
-    // A array of tokens, the output
-    std::vector<Token> tokens;
+    std::array<std::array<uint8_t, 256>, OPERATOR_STATES> next{};
+    std::array<TokenType, OPERATOR_STATES> accept{};
+    size_t states = 1;
+};
 
-    // The lexer loop
-    for (size_t i = 0; i < data.size(); )
+constexpr OperatorDFA make_operator_dfa()
+{
+    OperatorDFA dfa;
+    dfa.accept.fill(TokenType::NULLTOK);
+
+    for (const auto& op : operators)
     {
-        // Skip on whitespace
-        if (data[i] == ' ' || data[i] == '\n' || data[i] == '\r') 
+        size_t state = 0;
+        for (char c : op.str)
         {
-            i++; continue;
+            auto& next = dfa.next[state][(uint8_t) c];
+            if (!next) next = dfa.states++;
+            state = next;
         }
+        dfa.accept[state] = op.type;
+    }
 
-        // Check to see what type of character this is
-        if (strchr(ALPHABET, data[i]))
-        {
-            // It is an alphabetic character
-            std::string str;
-            do 
-            {   
-                // Create a string with all of the characters until a break (whitespace or a non alphanumeric character)
-                str.push_back(data[i]);
-                i++;
-            } while (strchr(/* Identifiers can be alphanumeric after the first character */ALPHANUMERIC, data[i]));
-
-            // If it is a keyword, add it to tokens
-            if (map.contains(str)) 
-            {
-                tokens.push_back(map[str]);
-                tokens.back().value = str;
-            }
-            else 
-            {
-                // Create a identifier from the string
-                tokens.push_back(map["[alphan]"]);
-                tokens.back().value = str;
-            }
-        }  
-        else if (strchr(DIGITS, data[i]) || (data[i] == '-' && strchr(DIGITS, data[i + 1]))) 
+    return dfa;
+}
+
+constexpr OperatorDFA operator_dfa = make_operator_dfa();
+static_assert(operator_dfa.states <= OPERATOR_STATES, "Too many operator states for the lexer DFA");
+
+// Perfect hash for keywords, the seed is searched for at compile time so no two keywords share a slot
+constexpr size_t KEYWORD_SLOTS = 32;
+
+constexpr uint32_t keyword_hash(std::string_view str, uint32_t seed)
+{
+    uint32_t h = (uint8_t) str.front() * seed + (uint8_t) str.back() * 31 + (uint32_t) str.size();
+    return (h * 2654435761u) >> 27;
+}
+
+constexpr uint32_t find_keyword_seed()
+{
+    for (uint32_t seed = 1; seed < 1024; seed++)
+    {
+        std::array<bool, KEYWORD_SLOTS> used{};
+        bool collision = false;
+        for (const auto& kw : keywords)
         {
-            std::string numstr;
+            uint32_t h = keyword_hash(kw.str, seed);
+            if (used[h]) { collision = true; break; }
+            used[h] = true;
+        }
+        if (!collision) return seed;
+    }
+    return 0;
+}
 
-            do 
-            {
-                // Create a string with all of the characters until a break (whitespace or a non number character)
-                numstr.push_back(data[i]);
-                i++;
-            } while (strchr(DIGITS, data[i]) || data[i] == '.');
-
-            // Can't have character at end of number
-            if (strchr(ALPHABET, data[i])) throw compiler_error("%c is not an expected digit", data[i]);
-            
-            // Create the number token
-            if (std::count(numstr.begin(), numstr.end(), '.') > 1) throw compiler_error("%s is not a valid literal\n", numstr.c_str()); 
-            Token create = numstr.find('.') != std::string::npos ? map["[float]"] : map["[integer]"];
-            create.value = numstr;
-            tokens.push_back(create);
+constexpr uint32_t keyword_seed = find_keyword_seed();
+static_assert(keyword_seed != 0, "No perfect hash seed found for the keywords");
+
+constexpr std::array<Spelling, KEYWORD_SLOTS> make_keyword_table()
+{
+    std::array<Spelling, KEYWORD_SLOTS> table{};
+    for (auto& slot : table) slot = {"", TokenType::IDENT};
+    for (const auto& kw : keywords) table[keyword_hash(kw.str, keyword_seed)] = kw;
+    return table;
+}
+
+constexpr std::array<Spelling, KEYWORD_SLOTS> keyword_table = make_keyword_table();
+
+// Returns the keyword type of str, or IDENT if it is not a keyword
+inline TokenType keyword_type(std::string_view str)
+{
+    const Spelling& slot = keyword_table[keyword_hash(str, keyword_seed)];
+    return slot.str == str ? slot.type : TokenType::IDENT;
+}
+
+Tokenizer::Tokenizer(std::string&& data)
+    : owned(std::move(data)), source(owned)
+{
+    if (source.size() > UINT32_MAX) throw compiler_error("Source file is too large");
+    while (!done) lex();
+}
+
+// Longest run of a character class the lexer scans itself before handing it to the simd scanners
+constexpr size_t SHORT_RUN = 16;
+
+// The lexer function, lexes the token starting at lex_pos (skipping whitespace) into the stream
+void Tokenizer::lex()
+{
+    const char* src = source.data();
+    const size_t size = source.size();
+    size_t i = lex_pos;
+
+    // Short runs are scanned here, the simd scanners only pay off once a run is longer than a block
+    size_t block_end = std::min(size, i + SHORT_RUN);
+
+    // Skip on whitespace
+    for (; i < block_end && is_class(src[i], CC_SPACE); i++)
+    {
+        if (src[i] == '\n')
+        {
+            line++;
+            line_start = i + 1;
         }
-        else
+    }
+    if (i == block_end && i < size && is_class(src[i], CC_SPACE)) i = scanners.space(src, i, size, line, line_start);
+
+    size_t start = i;
+    SourceLoc loc{line, (uint32_t) (start - line_start + 1)};
+
+    if (i >= size)
+    {
+        // Add the sentinel
+        push(TokenType::NULLTOK, size, 0, loc);
+        lex_pos = i;
+        done = true;
+        return;
+    }
+
+    char c = src[i];
+
+    // Check to see what type of character this is
+    if (is_class(c, CC_ALPHA))
+    {
+        // Identifiers can be alphanumeric after the first character
+        block_end = std::min(size, i + SHORT_RUN);
+        do i++; while (i < block_end && is_class(src[i], CC_ALPHA | CC_DIGIT));
+        if (i == block_end) i = scanners.alnum(src, i, size);
+
+        std::string_view str(src + start, i - start);
+        TokenType type = keyword_type(str);
+        push(type, start, i - start, loc, type == TokenType::IDENT ? intern(str) : NO_SYMBOL);
+    }
+    else if (is_class(c, CC_DIGIT) || (c == '-' && i + 1 < size && is_class(src[i + 1], CC_DIGIT)))
+    {
+        block_end = std::min(size, i + SHORT_RUN);
+        do i++; while (i < block_end && (is_class(src[i], CC_DIGIT) || src[i] == '.'));
+        if (i == block_end) i = scanners.number(src, i, size);
+        size_t dots = std::count(src + start, src + i, '.');
+
+        // Can't have character at end of number
+        if (i < size && is_class(src[i], CC_ALPHA)) throw compiler_error("%u:%u: %c is not an expected digit", loc.line, loc.col, src[i]);
+
+        // Create the number token
+        if (dots > 1) throw compiler_error("%u:%u: %s is not a valid literal\n", loc.line, loc.col, std::string(src + start, i - start).c_str());
+        push(dots ? TokenType::FLOATV : TokenType::INTV, start, i - start, loc);
+    }
+    else
+    {
+        // Run the operator DFA as far as it goes, and keep the longest match
+        TokenType type = TokenType::NULLTOK;
+        size_t end = i;
+        for (size_t state = 0; i < size && (state = operator_dfa.next[state][(uint8_t) src[i]]); )
         {
-            // A character group can at most be 3 characters
-            if (map.contains(data.substr(i, 3))) 
-            {
-                tokens.push_back(map[data.substr(i, 3)]);
-                tokens.back().value = data.substr(i, 3);   
-                i+=3;  
-            }     
-            else if (map.contains(data.substr(i, 2))) 
+            i++;
+            if (operator_dfa.accept[state] != TokenType::NULLTOK)
             {
-                tokens.push_back(map[data.substr(i, 2)]);  
-                tokens.back().value = data.substr(i, 2);   
-                i+=2;
-            }      
-            else if (map.contains(data.substr(i, 1))) 
-            {
-                tokens.push_back(map[data.substr(i, 1)]);
-                tokens.back().value = data.substr(i, 1);   
-                i++;
-            }          
-            else throw compiler_error("Invalid expression: %c", data[i]);
+                type = operator_dfa.accept[state];
+                end = i;
+            }
         }
+
+        if (type == TokenType::NULLTOK) throw compiler_error("%u:%u: Invalid expression: %c", loc.line, loc.col, c);
+        i = end;
+        push(type, start, end - start, loc);
     }
 
-    return Tokenizer(std::move(tokens));
-}
\ No newline at end of file
+    lex_pos = i;
+}
+
+Tokenizer scan(std::string data)
+{
+    return Tokenizer(std::move(data));
+}
+
+Tokenizer stream(std::string_view data)
+{
+    if (data.size() > UINT32_MAX) throw compiler_error("Source file is too large");
+    return Tokenizer(data);
+}
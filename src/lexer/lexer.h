@@ -5,5 +5,8 @@
 
 #include "token.h"
 
-// Lex a string following the rules of the map
-Tokenizer scan(std::string data);
\ No newline at end of file
+// Lex all of a string
+Tokenizer scan(std::string data);
+
+// Lex a view of the source (like a mapped file) as the parser pulls tokens, data has to outlive the tokenizer
+Tokenizer stream(std::string_view data);
\ No newline at end of file
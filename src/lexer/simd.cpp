@@ -0,0 +1,179 @@
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86
+#endif
+
+// Scalar versions, also used for the tail of the simd versions
+
+static size_t space_scalar(const char* src, size_t i, size_t size, uint32_t& line, size_t& line_start)
+{
+    for (; i < size && is_class(src[i], CC_SPACE); i++)
+    {
+        if (src[i] == '\n')
+        {
+            line++;
+            line_start = i + 1;
+        }
+    }
+    return i;
+}
+
+static size_t alnum_scalar(const char* src, size_t i, size_t size)
+{
+    while (i < size && is_class(src[i], CC_ALPHA | CC_DIGIT)) i++;
+    return i;
+}
+
+static size_t number_scalar(const char* src, size_t i, size_t size)
+{
+    while (i < size && (is_class(src[i], CC_DIGIT) || src[i] == '.')) i++;
+    return i;
+}
+
+#ifdef SIMD_X86
+
+// Every block is classified into a bitmask of bytes in the class, the run ends at the first zero bit
+// Ranges use the signed compare trick, shifting lo to -128 so one compare checks both ends
+
+static inline __m128i in_range_sse2(__m128i v, char lo, char hi)
+{
+    return _mm_cmplt_epi8(_mm_sub_epi8(v, _mm_set1_epi8((char) (lo ^ 0x80))), _mm_set1_epi8((char) (hi - lo + 1 - 128)));
+}
+
+static size_t space_sse2(const char* src, size_t i, size_t size, uint32_t& line, size_t& line_start)
+{
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i nl = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+        __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))), _mm_or_si128(nl, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+
+        uint32_t end = ~_mm_movemask_epi8(space) & 0xFFFF;
+        uint32_t newlines = _mm_movemask_epi8(nl);
+        if (end) newlines &= (1u << __builtin_ctz(end)) - 1;
+        if (newlines)
+        {
+            line += __builtin_popcount(newlines);
+            line_start = i + 32 - __builtin_clz(newlines);
+        }
+        if (end) return i + __builtin_ctz(end);
+    }
+    return space_scalar(src, i, size, line, line_start);
+}
+
+static size_t alnum_sse2(const char* src, size_t i, size_t size)
+{
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i alpha = in_range_sse2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+        __m128i alnum = _mm_or_si128(_mm_or_si128(alpha, in_range_sse2(v, '0', '9')), _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+
+        uint32_t end = ~_mm_movemask_epi8(alnum) & 0xFFFF;
+        if (end) return i + __builtin_ctz(end);
+    }
+    return alnum_scalar(src, i, size);
+}
+
+static size_t number_sse2(const char* src, size_t i, size_t size)
+{
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i number = _mm_or_si128(in_range_sse2(v, '0', '9'), _mm_cmpeq_epi8(v, _mm_set1_epi8('.')));
+
+        uint32_t end = ~_mm_movemask_epi8(number) & 0xFFFF;
+        if (end) return i + __builtin_ctz(end);
+    }
+    return number_scalar(src, i, size);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i in_range_avx2(__m256i v, char lo, char hi)
+{
+    return _mm256_cmpgt_epi8(_mm256_set1_epi8((char) (hi - lo + 1 - 128)), _mm256_sub_epi8(v, _mm256_set1_epi8((char) (lo ^ 0x80))));
+}
+
+__attribute__((target("avx2")))
+static size_t space_avx2(const char* src, size_t i, size_t size, uint32_t& line, size_t& line_start)
+{
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (src + i));
+        __m256i nl = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+        __m256i space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))), _mm256_or_si256(nl, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+
+        uint32_t end = ~(uint32_t) _mm256_movemask_epi8(space);
+        uint32_t newlines = _mm256_movemask_epi8(nl);
+        if (end) newlines &= (uint32_t) ((1ull << __builtin_ctz(end)) - 1);
+        if (newlines)
+        {
+            line += __builtin_popcount(newlines);
+            line_start = i + 32 - __builtin_clz(newlines);
+        }
+        if (end) return i + __builtin_ctz(end);
+    }
+    return space_sse2(src, i, size, line, line_start);
+}
+
+__attribute__((target("avx2")))
+static size_t alnum_avx2(const char* src, size_t i, size_t size)
+{
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (src + i));
+        __m256i alpha = in_range_avx2(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i alnum = _mm256_or_si256(_mm256_or_si256(alpha, in_range_avx2(v, '0', '9')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+
+        uint32_t end = ~(uint32_t) _mm256_movemask_epi8(alnum);
+        if (end) return i + __builtin_ctz(end);
+    }
+    return alnum_sse2(src, i, size);
+}
+
+__attribute__((target("avx2")))
+static size_t number_avx2(const char* src, size_t i, size_t size)
+{
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (src + i));
+        __m256i number = _mm256_or_si256(in_range_avx2(v, '0', '9'), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')));
+
+        uint32_t end = ~(uint32_t) _mm256_movemask_epi8(number);
+        if (end) return i + __builtin_ctz(end);
+    }
+    return number_sse2(src, i, size);
+}
+
+#endif
+
+static Scanners scanners_for(ScanLevel level)
+{
+    switch (level)
+    {
+#ifdef SIMD_X86
+        case ScanLevel::AVX2: return {space_avx2, alnum_avx2, number_avx2};
+        case ScanLevel::SSE2: return {space_sse2, alnum_sse2, number_sse2};
+#endif
+        default: return {space_scalar, alnum_scalar, number_scalar};
+    }
+}
+
+ScanLevel best_scan_level()
+{
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return ScanLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return ScanLevel::SSE2;
+#endif
+    return ScanLevel::SCALAR;
+}
+
+void use_scan_level(ScanLevel level)
+{
+    scanners = scanners_for(level);
+}
+
+Scanners scanners = scanners_for(best_scan_level());
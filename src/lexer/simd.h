@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Character classes, so that checking a character is a single table load instead of a strchr
+enum CharClass : uint8_t
+{
+    CC_SPACE = 1 << 0,
+    CC_ALPHA = 1 << 1,
+    CC_DIGIT = 1 << 2,
+};
+
+constexpr std::array<uint8_t, 256> make_char_classes()
+{
+    std::array<uint8_t, 256> classes{};
+
+    classes[' '] = classes['\t'] = classes['\n'] = classes['\r'] = CC_SPACE;
+    for (int c = 'a'; c <= 'z'; c++) classes[c] = CC_ALPHA;
+    for (int c = 'A'; c <= 'Z'; c++) classes[c] = CC_ALPHA;
+    classes['_'] = CC_ALPHA;
+    for (int c = '0'; c <= '9'; c++) classes[c] = CC_DIGIT;
+
+    return classes;
+}
+
+constexpr std::array<uint8_t, 256> char_classes = make_char_classes();
+
+inline bool is_class(char c, uint8_t cls) { return char_classes[(uint8_t) c] & cls; }
+
+// The instruction sets the lexer can scan runs of characters with
+enum class ScanLevel
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// Scanners for runs of characters, each returns the index of the first character from i that isn't part of the run
+struct Scanners
+{
+    // Whitespace, also counts the newlines passed and where the last line started
+    size_t (*space)(const char* src, size_t i, size_t size, uint32_t& line, size_t& line_start);
+    // Identifier characters, [A-Za-z0-9_]
+    size_t (*alnum)(const char* src, size_t i, size_t size);
+    // Number characters, [0-9.]
+    size_t (*number)(const char* src, size_t i, size_t size);
+};
+
+// The scanners used by the lexer
+extern Scanners scanners;
+
+// The best level this cpu supports (from cpuid)
+ScanLevel best_scan_level();
+
+// Switch the scanners the lexer uses, they start out at best_scan_level() and level has to be supported by the cpu
+void use_scan_level(ScanLevel level);
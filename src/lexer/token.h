@@ -1,13 +1,16 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include <iostream>
 
 #include "error/error.h"
+#include "intern.h"
 
-enum class TokenType
+enum class TokenType : uint8_t
 {
     OBRACKET,
     CBRACKET,
@@ -58,55 +61,138 @@ enum class TokenType
     NULLTOK
 };
 
+// Number of token types, for tables indexed by TokenType
+constexpr size_t TOKEN_TYPES = (size_t) TokenType::NULLTOK + 1;
+
+// Line and column of a token in the source, both start at 1
+struct SourceLoc
+{
+    uint32_t line = 0;
+    uint32_t col = 0;
+};
+
 // A lexer token containing a type and a value
+// This is only a view, the value points into the source kept alive by the tokenizer
+// Identifiers also carry their interned symbol
 struct Token
 {
     TokenType type;
-    std::string value;
+    SymbolId sym = NO_SYMBOL;
+    std::string_view value;
+    SourceLoc loc;
 
     Token()
-        : type(TokenType::NULLTOK), value(std::string())
+        : type(TokenType::NULLTOK)
     {
 
     }
 
     Token(TokenType type)
-        : type(type), value(std::string())
+        : type(type)
     {
 
     }
 
-    Token(TokenType type, const std::string& value)
-        : type(type), value(value)
+    Token(TokenType type, std::string_view value, SourceLoc loc = {}, SymbolId sym = NO_SYMBOL)
+        : type(type), sym(sym), value(value), loc(loc)
     {
 
     }
 };
 
-// The tokenizer class to manage the token vector, in the parser
+// The tokenizer class to manage the token stream, in the parser
+// Tokens are stored as parallel arrays of offsets into the source, followed by a NULLTOK sentinel
+// Given the whole source string every token is lexed up front, given a view of the source (like a mapped file) 
+// tokens are lexed as the parser asks for them and only the last RING_SIZE are kept
 class Tokenizer
 {
 private:
-    std::vector<Token> tokens;
+    // Only used when the tokenizer owns the source, otherwise whoever made the tokenizer keeps it alive
+    std::string owned;
+    std::string_view source;
+
+    // Where the lexer is in the source
+    size_t lex_pos = 0;
+    uint32_t line = 1;
+    size_t line_start = 0;
+    bool done = false;
+
+    std::vector<TokenType> types;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<SourceLoc> locs;
+    std::vector<SymbolId> syms;
+
+    // Number of tokens lexed so far (the sentinel included), and the mask to find their slot
+    size_t lexed = 0;
+    size_t mask = SIZE_MAX;
     size_t pos = 0;
+
+    // Lexes the next token, or the sentinel at the end of the source (in lexer.cpp)
+    void lex();
+    void push(TokenType type, size_t offset, size_t length, SourceLoc loc, SymbolId sym = NO_SYMBOL)
+    {
+        if (mask == SIZE_MAX)
+        {
+            types.push_back(type);
+            offsets.push_back(offset);
+            lengths.push_back(length);
+            locs.push_back(loc);
+            syms.push_back(sym);
+        }
+        else
+        {
+            size_t slot = lexed & mask;
+            types[slot] = type;
+            offsets[slot] = offset;
+            lengths[slot] = length;
+            locs[slot] = loc;
+            syms[slot] = sym;
+        }
+        lexed++;
+    }
+
+    // Reading past the end gives the sentinel instead of throwing
+    Token at(size_t idx) 
+    { 
+        while (idx >= lexed && !done) lex();
+        if (idx >= lexed) idx = lexed - 1;
+        if (lexed - idx > mask) throw compiler_error("Token %zu is no longer in the lookahead window", idx);
+
+        size_t slot = idx & mask;
+        return Token(types[slot], source.substr(offsets[slot], lengths[slot]), locs[slot], syms[slot]); 
+    }
 public:
-    Tokenizer(std::vector<Token>&& tokens)
-        : tokens(std::move(tokens)), pos(0)
-    {   
+    static constexpr size_t RING_SIZE = 256;
+
+    // Lexes all of source (in lexer.cpp)
+    Tokenizer(std::string&& data);
+
+    // Lexes source on demand, source has to outlive the tokenizer and the tokens taken from it
+    Tokenizer(std::string_view source)
+        : source(source), types(RING_SIZE), offsets(RING_SIZE), lengths(RING_SIZE), locs(RING_SIZE), syms(RING_SIZE), mask(RING_SIZE - 1)
+    {
 
     }
 
-    Token& operator[](size_t idx) { return tokens.at(idx); }
+    // Token views point into the tokenizer, so it can't be moved around
+    Tokenizer(const Tokenizer&) = delete;
+    Tokenizer& operator=(const Tokenizer&) = delete;
+
+    Token operator[](size_t idx) { return at(idx); }
     
-    Token cur() { return tokens.at(pos); };
-    Token cur(size_t idx) { return tokens.at(pos + idx); }
-    Token prev() { return tokens.at(pos - 1); }
-    Token inc() { pos++; return tokens.at(pos - 1); }
-    Token next() { if (pos + 1 >= tokens.size()) return Token(TokenType::NULLTOK); return tokens.at(pos + 1); }
-    size_t size() { return tokens.size(); }
+    Token cur() { return at(pos); };
+    Token cur(size_t idx) { return at(pos + idx); }
+    // Throws at the first token, pos - 1 would wrap around and lex all of the source to reach it
+    Token prev() { if (pos == 0) throw compiler_error("There is no token before the first one"); return at(pos - 1); }
+    Token inc() { pos++; return at(pos - 1); }
+    Token next() { return at(pos + 1); }
+    // Number of tokens, this lexes the rest of the source if it hasn't been yet
+    size_t size() { while (!done) lex(); return lexed - 1; }
     size_t getPos() { return pos; }
     void setPos(size_t pos) { this->pos = pos; }
-    void check(const std::string& str) { if (pos >= tokens.size()) throw compiler_error(str); }
+    bool end() { return cur().type == TokenType::NULLTOK; }
+    void check(const char* str) { if (end()) throw compiler_error(str); }
 };
 
 std::ostream& operator<<(std::ostream& os, const Token& t);
\ No newline at end of file
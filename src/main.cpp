@@ -2,9 +2,7 @@
 #include <chrono>
 
 #include "lexer/lexer.h"
-#include "parser/parser.h"
-#include "symt/symt.h"
-#include "codegen/codegen.h"
+#include "compile.h"
 // #include "error/error.h"
 #include "util.h"
 
@@ -15,10 +13,10 @@ int main(int argc, char** argv)
     try
     {
         auto startTm = std::chrono::high_resolution_clock::now();
-        auto tokens = scan(read_file(argv[1]));
-        Node* node = parse_program(tokens);
-        generate_symtables(node);
-        write_file(argv[2], codegen(node));
+        MappedFile file(argv[1]);
+        auto tokens = stream(file.data());
+        write_file(argv[2], compile(tokens));
+        node_arena.release();
         std::cout << "Elapsed Time: " << (double) (std::chrono::high_resolution_clock::now() - startTm).count() / (double) 1000000 << "ms" << std::endl;
     }
     catch (compiler_error& e)
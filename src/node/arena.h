@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A list of items allocated in an arena, it doesn't own them
+template <typename T>
+struct ArenaList
+{
+    T* items = nullptr;
+    uint32_t count = 0;
+
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t idx) const { return items[idx]; }
+};
+
+// Bump pointer allocator, everything allocated from it is freed at once by release()
+// Destructors are never run, so only trivially destructible types can be made in it
+class Arena
+{
+private:
+    static constexpr size_t MIN_BLOCK_SIZE = 1 << 16;
+    static constexpr size_t MAX_BLOCK_SIZE = 1 << 20;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    uintptr_t cur = 0;
+    uintptr_t limit = 0;
+    size_t next_block_size = MIN_BLOCK_SIZE;
+
+    size_t objects = 0;
+    size_t bytes = 0;
+
+    void grow(size_t size)
+    {
+        size_t block_size = size > next_block_size ? size : next_block_size;
+        blocks.emplace_back(new char[block_size]);
+        cur = (uintptr_t) blocks.back().get();
+        limit = cur + block_size;
+        if (next_block_size < MAX_BLOCK_SIZE) next_block_size *= 2;
+    }
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* alloc(size_t size, size_t align)
+    {
+        uintptr_t ptr = (cur + align - 1) & ~(uintptr_t) (align - 1);
+        if (!cur || ptr + size > limit)
+        {
+            grow(size + align);
+            ptr = (cur + align - 1) & ~(uintptr_t) (align - 1);
+        }
+        cur = ptr + size;
+        bytes += size;
+        return (void*) ptr;
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "Arena objects are never destroyed");
+        objects++;
+        return new (alloc(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Copies count items into the arena
+    template <typename T>
+    ArenaList<T> make_list(const T* items, size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "Arena objects are never destroyed");
+        ArenaList<T> list;
+        if (!count) return list;
+        list.items = (T*) alloc(sizeof(T) * count, alignof(T));
+        list.count = count;
+        std::uninitialized_copy(items, items + count, list.items);
+        return list;
+    }
+
+    // Frees everything allocated so far
+    void release()
+    {
+        blocks.clear();
+        cur = limit = 0;
+        next_block_size = MIN_BLOCK_SIZE;
+        objects = bytes = 0;
+    }
+
+    size_t object_count() const { return objects; }
+    size_t bytes_used() const { return bytes; }
+};
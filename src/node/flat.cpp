@@ -0,0 +1,183 @@
+#include "flat.h"
+
+#include "error/error.h"
+
+FlatTypeId FlatAst::type_id(const Type& type)
+{
+    // Programs only use a handful of types, so a linear search is enough
+    for (size_t i = 0; i < types.size(); i++)
+    {
+        if (types[i] == type && types[i].is_const == type.is_const) return i;
+    }
+    if (types.size() > UINT16_MAX) throw compiler_error("Too many types for the flat AST");
+    types.push_back(type);
+    return types.size() - 1;
+}
+
+size_t FlatAst::node_count() const
+{
+    return functions.size() + args.size() + decls.size() + blocks.size() + termchecks.size() + rets.size() + ifs.size() + fors.size() + whiles.size()
+        + casts.size() + unaries.size() + binaries.size() + terns.size() + literals.size() + vars.size() + funcalls.size() + empty_nodes + 1;
+}
+
+template <typename T>
+static size_t pool_bytes(const std::vector<T>& pool) { return pool.size() * sizeof(T); }
+
+size_t FlatAst::bytes() const
+{
+    return pool_bytes(types) + pool_bytes(functions) + pool_bytes(args) + pool_bytes(decls) + pool_bytes(blocks) + pool_bytes(termchecks) + pool_bytes(rets)
+        + pool_bytes(ifs) + pool_bytes(fors) + pool_bytes(whiles) + pool_bytes(casts) + pool_bytes(unaries) + pool_bytes(binaries) + pool_bytes(terns)
+        + pool_bytes(literals) + pool_bytes(vars) + pool_bytes(funcalls) + pool_bytes(extra) + sizeof(FlatAst);
+}
+
+// Pushes a node onto its pool and returns the handle to it
+template <typename T>
+static NodeRef push(std::vector<T>& pool, NodeType type, const T& node)
+{
+    if (pool.size() > NodeRef::INDEX_MASK) throw compiler_error("Too many nodes for the flat AST");
+    pool.push_back(node);
+    return NodeRef(type, pool.size() - 1);
+}
+
+class Flattener
+{
+private:
+    FlatAst& ast;
+
+    // Children of a list are flattened first (which can push their own lists), then the list is copied into extra
+    std::vector<NodeRef> scratch;
+
+    ExtraRange list(const NodeList& nodes)
+    {
+        size_t start = scratch.size();
+        for (Node* node : nodes) scratch.push_back(flatten(node));
+
+        ExtraRange range{(uint32_t) ast.extra.size(), (uint32_t) (scratch.size() - start)};
+        ast.extra.insert(ast.extra.end(), scratch.begin() + start, scratch.end());
+        scratch.resize(start);
+        return range;
+    }
+public:
+    Flattener(FlatAst& ast) : ast(ast) {}
+
+    NodeRef flatten(Node* node)
+    {
+        if (!node) return {};
+
+        switch (node->node_type)
+        {
+            case NodeType::FUNCTION:
+            {
+                auto* fn = static_cast<FunctionNode*>(node);
+                uint32_t args_begin = ast.args.size();
+                for (const ArgNode& arg : fn->args) ast.args.push_back({arg.tok.sym, ast.type_id(arg.type)});
+                ExtraRange body = list(fn->statements.forward);
+                return push(ast.functions, NodeType::FUNCTION, {fn->name.sym, ast.type_id(fn->type), fn->defined, args_begin, (uint32_t) fn->args.size(), body});
+            }
+            case NodeType::DECL:
+            {
+                auto* decl = static_cast<DeclNode*>(node);
+                NodeRef assign = flatten(decl->assign);
+                return push(ast.decls, NodeType::DECL, {decl->name.sym, ast.type_id(decl->type), decl->defined, assign});
+            }
+            case NodeType::BLOCKSTMT:
+            {
+                auto* block = static_cast<BlockStmtNode*>(node);
+                return push(ast.blocks, NodeType::BLOCKSTMT, {list(block->forward)});
+            }
+            case NodeType::TERMCHECK:
+                return push(ast.termchecks, NodeType::TERMCHECK, {flatten(static_cast<TerminatorCheckNode*>(node)->forward)});
+            case NodeType::RETURN:
+                return push(ast.rets, NodeType::RETURN, {flatten(static_cast<RetNode*>(node)->value)});
+            case NodeType::IF:
+            {
+                auto* inode = static_cast<IfNode*>(node);
+                FlatIf flat;
+                flat.condition = flatten(inode->condition);
+                flat.statement = flatten(inode->statement);
+                flat.else_stmt = flatten(inode->else_stmt);
+                return push(ast.ifs, NodeType::IF, flat);
+            }
+            case NodeType::FOR:
+            {
+                auto* fnode = static_cast<ForNode*>(node);
+                FlatFor flat;
+                flat.initial = flatten(fnode->initial);
+                flat.condition = flatten(fnode->condition);
+                flat.end = flatten(fnode->end);
+                flat.statement = flatten(fnode->statement);
+                return push(ast.fors, NodeType::FOR, flat);
+            }
+            case NodeType::WHILE:
+            {
+                auto* wnode = static_cast<WhileNode*>(node);
+                FlatWhile flat;
+                flat.condition = flatten(wnode->condition);
+                flat.statement = flatten(wnode->statement);
+                flat.do_on = wnode->do_on;
+                return push(ast.whiles, NodeType::WHILE, flat);
+            }
+            case NodeType::CAST:
+            {
+                auto* cast = static_cast<CastNode*>(node);
+                NodeRef forward = flatten(cast->forward);
+                return push(ast.casts, NodeType::CAST, {forward, ast.type_id(cast->type)});
+            }
+            case NodeType::UNARY:
+            {
+                auto* op = static_cast<UnaryOpNode*>(node);
+                return push(ast.unaries, NodeType::UNARY, {flatten(op->forward), op->op});
+            }
+            case NodeType::BINARY:
+            {
+                auto* op = static_cast<BinaryOpNode*>(node);
+                FlatBinary flat;
+                flat.lhs = flatten(op->lhs);
+                flat.rhs = flatten(op->rhs);
+                flat.op = op->op;
+                return push(ast.binaries, NodeType::BINARY, flat);
+            }
+            case NodeType::TERN:
+            {
+                auto* tern = static_cast<TernNode*>(node);
+                FlatTern flat;
+                flat.condition = flatten(tern->condition);
+                flat.lhs = flatten(tern->lhs);
+                flat.rhs = flatten(tern->rhs);
+                flat.forceboolout = tern->forceboolout;
+                return push(ast.terns, NodeType::TERN, flat);
+            }
+            case NodeType::LITERAL:
+            {
+                auto* lit = static_cast<LiteralNode*>(node);
+                return push(ast.literals, NodeType::LITERAL, {lit->value, ast.type_id(lit->type)});
+            }
+            case NodeType::VAR:
+                return push(ast.vars, NodeType::VAR, {static_cast<VarNode*>(node)->name.sym});
+            case NodeType::FUNCALL:
+            {
+                auto* fn = static_cast<FuncallNode*>(node);
+                return push(ast.funcalls, NodeType::FUNCALL, {fn->name.sym, list(fn->args)});
+            }
+            case NodeType::BREAK:
+            case NodeType::CONTINUE:
+            case NodeType::NOEXPR:
+                ast.empty_nodes++;
+                return NodeRef(node->node_type, 0);
+            default:
+                throw compiler_error("Node type %d can't be flattened", (int) node->node_type);
+        }
+    }
+
+    void flatten_program(ProgramNode* program)
+    {
+        ast.program = list(program->forward);
+    }
+};
+
+FlatAst flatten(ProgramNode* program)
+{
+    FlatAst ast;
+    Flattener(ast).flatten_program(program);
+    return ast;
+}
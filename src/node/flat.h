@@ -0,0 +1,126 @@
+#pragma once
+
+#include "node.h"
+
+// std
+#include <cstdint>
+#include <vector>
+
+// The flat AST
+// Holds the same tree as the Node graph, but every kind of node is kept in its own contiguous pool and nodes refer
+// to each other by 32-bit handles instead of pointers, lists are ranges of handles in one shared extra array
+// Nodes are pushed in post order (children before their parent), so a pass that doesn't care about the shape of
+// the tree can walk a pool front to back
+
+// Handle to a node, the node type is in the top bits and the index into the pool of that type in the rest
+// The default handle (NONE) is a null node
+struct NodeRef
+{
+    static constexpr uint32_t INDEX_BITS = 27;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+
+    uint32_t bits = 0;
+
+    NodeRef() = default;
+    NodeRef(NodeType type, uint32_t index) : bits(((uint32_t) type << INDEX_BITS) | index) {}
+
+    NodeType type() const { return (NodeType) (bits >> INDEX_BITS); }
+    uint32_t index() const { return bits & INDEX_MASK; }
+    explicit operator bool() const { return bits != 0; }
+};
+
+static_assert((uint32_t) NodeType::WHILE < (1u << (32 - NodeRef::INDEX_BITS)), "Node types don't fit in a NodeRef");
+
+// A list of handles, a range of FlatAst::extra
+struct ExtraRange
+{
+    uint32_t begin = 0;
+    uint32_t count = 0;
+};
+
+// Index into FlatAst::types
+using FlatTypeId = uint16_t;
+
+// One struct per node type, only holding what the passes read
+// Break, continue and empty expressions have no data so they have no pool
+struct FlatFunction
+{
+    SymbolId name;
+    FlatTypeId type;
+    bool defined;
+    // Range of FlatAst::args
+    uint32_t args_begin;
+    uint32_t args_count;
+    ExtraRange body;
+};
+
+struct FlatArg
+{
+    SymbolId name;
+    FlatTypeId type;
+};
+
+struct FlatDecl
+{
+    SymbolId name;
+    FlatTypeId type;
+    bool defined;
+    NodeRef assign;
+};
+
+struct FlatBlock { ExtraRange items; };
+struct FlatTermCheck { NodeRef forward; };
+struct FlatRet { NodeRef value; };
+struct FlatIf { NodeRef condition, statement, else_stmt; };
+struct FlatFor { NodeRef initial, condition, end, statement; };
+struct FlatWhile { NodeRef condition, statement; bool do_on; };
+struct FlatCast { NodeRef forward; FlatTypeId type; };
+struct FlatUnary { NodeRef forward; NodeKind op; };
+struct FlatBinary { NodeRef lhs, rhs; NodeKind op; };
+struct FlatTern { NodeRef condition, lhs, rhs; bool forceboolout; };
+struct FlatLiteral { LiteralValue value; FlatTypeId type; };
+struct FlatVar { SymbolId name; };
+struct FlatFuncall { SymbolId name; ExtraRange args; };
+
+struct FlatAst
+{
+    // Every distinct type used by the tree, nodes store an index into this
+    std::vector<Type> types;
+
+    std::vector<FlatFunction> functions;
+    std::vector<FlatArg> args;
+    std::vector<FlatDecl> decls;
+    std::vector<FlatBlock> blocks;
+    std::vector<FlatTermCheck> termchecks;
+    std::vector<FlatRet> rets;
+    std::vector<FlatIf> ifs;
+    std::vector<FlatFor> fors;
+    std::vector<FlatWhile> whiles;
+    std::vector<FlatCast> casts;
+    std::vector<FlatUnary> unaries;
+    std::vector<FlatBinary> binaries;
+    std::vector<FlatTern> terns;
+    std::vector<FlatLiteral> literals;
+    std::vector<FlatVar> vars;
+    std::vector<FlatFuncall> funcalls;
+
+    // Child lists of blocks, calls and the program
+    std::vector<NodeRef> extra;
+
+    // The top level functions and global declarations in source order
+    ExtraRange program;
+
+    // Number of nodes with no pool
+    uint32_t empty_nodes = 0;
+
+    FlatTypeId type_id(const Type& type);
+    const Type& type(FlatTypeId id) const { return types[id]; }
+    NodeRef item(ExtraRange list, size_t idx) const { return extra[list.begin + idx]; }
+
+    // Number of nodes and bytes used by the pools
+    size_t node_count() const;
+    size_t bytes() const;
+};
+
+// Builds the flat form of a parsed program
+FlatAst flatten(ProgramNode* program);
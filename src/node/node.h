@@ -3,11 +3,15 @@
 #include <string>
 #include <vector>
 #include <iostream>
-#include <memory>
-#include <list>
 
 #include "lexer/token.h"
 #include "type.h"
+#include "arena.h"
+
+struct FuncEntry;
+struct GlobalEntry;
+struct Codegen;
+struct ExprResult;
 
 enum class NodeKind
 {   
@@ -60,6 +64,32 @@ enum class Location
     LOCAL, GLOBAL, FUNCTION
 };
 
+// Which node struct a node is, so a node can be identified without going through its vtable
+enum class NodeType : uint8_t
+{
+    NONE,
+    PROGRAM,
+    ARG,
+    BLOCKSTMT,
+    TERMCHECK,
+    FUNCTION,
+    NOEXPR,
+    CAST,
+    UNARY,
+    BINARY,
+    TERN,
+    LITERAL,
+    VAR,
+    FUNCALL,
+    DECL,
+    BREAK,
+    CONTINUE,
+    RETURN,
+    IF,
+    FOR,
+    WHILE
+};
+
 // Holds additional data that is passed into the visit functions so they have some context
 struct AdditionalArgs
 {
@@ -70,34 +100,56 @@ struct AdditionalArgs
 // The Node struct
 // Holds data for a parser node
 
+// Nodes are allocated in node_arena and freed all at once, so they have to stay trivially destructible
+// There is no vtable, node_type says which struct a node is and passes switch on it
 struct Node
 {
-    // For every node, will codegen output of the nodetype
-    virtual void visit(std::string* write) = 0;
-    virtual void visit_symt() {}
-    virtual ~Node() = 0;
+    NodeType node_type;
+
+    Node(NodeType node_type) : node_type(node_type) {}
+
+    // For every node, will codegen output of the nodetype, statements give an empty result
+    // These dispatch on node_type to the function of the actual node struct (see visit_node), codegen's is defined with the rest of codegen
+    ExprResult visit(Codegen* gen);
+    void visit_symt();
+};
+
+using NodeList = ArenaList<Node*>;
+
+// The arena every node of the compilation unit is allocated in
+extern Arena node_arena;
+
+// Base of every node that is an expression
+struct ExprNode : Node
+{
+    ExprNode(NodeType node_type) : Node(node_type) {}
+
+    // Set by check_types, the type the expression evaluates to
+    Type expr_type = {TypeKind::NULLTP, 0};
 };
 
 struct ProgramNode : Node
 {
+    ProgramNode() : Node(NodeType::PROGRAM) {}
+
     // List of every node, going forward
-    std::list<std::unique_ptr<Node>> forward;
+    NodeList forward;
 
     // Codegen
-    virtual void visit(std::string* write) override;
-    void visit_symt() override
+    ExprResult visit(Codegen* gen);
+    void visit_symt()
     {
         for (auto i = std::begin(forward); i != std::end(forward); i++)
         {
             (*i)->visit_symt();
         }
     }
-
-    ~ProgramNode() override {}
 };
 
 struct ArgNode : Node
 {
+    ArgNode() : Node(NodeType::ARG) {}
+
     // Type of argument
     Type type;
     
@@ -105,36 +157,36 @@ struct ArgNode : Node
     Token tok;
 
     // Codegen
-    virtual void visit(std::string* write) override;
-
-    ~ArgNode() override {}
+    ExprResult visit(Codegen* gen);
 };
 
 struct BlockStmtNode : Node
 {   
+    BlockStmtNode() : Node(NodeType::BLOCKSTMT) {}
+
     // Every statment in the block statment
-    std::list<std::unique_ptr<Node>> forward;
+    NodeList forward;
 
     // Codegen
-    virtual void visit(std::string* write) override;
-
-    ~BlockStmtNode() override {}
+    ExprResult visit(Codegen* gen);
 };
 
 // This is used for generating proper terminator
 struct TerminatorCheckNode : Node
 {   
+    TerminatorCheckNode() : Node(NodeType::TERMCHECK) {}
+
     // Every statment in the block statment
     Node* forward;
 
     // Codegen
-    virtual void visit(std::string* write) override;
-
-    ~TerminatorCheckNode() override { if (forward) delete forward; }
+    ExprResult visit(Codegen* gen);
 };
 
 struct FunctionNode : Node
 {
+    FunctionNode() : Node(NodeType::FUNCTION) {}
+
     // Return type of the function
     Type type; 
 
@@ -145,68 +197,68 @@ struct FunctionNode : Node
     bool defined = false;
 
     // List of arguments
-    std::vector<ArgNode> args;
+    ArenaList<ArgNode> args;
+
+    // Set by resolve_names, the symtable entry of the function and the number of local slots it uses
+    FuncEntry* entry = nullptr;
+    uint32_t slot_count = 0;
 
     // List of every node (instruction) going forward
     BlockStmtNode statements;
 
     // Codegen
-    virtual void visit(std::string* write) override;
-    void visit_symt() override;
-
-    ~FunctionNode() override {}
+    ExprResult visit(Codegen* gen);
+    void visit_symt();
 };
 
-struct NoExpr : Node
+struct NoExpr : ExprNode
 {
-    virtual void visit(std::string* write) override;
+    NoExpr() : ExprNode(NodeType::NOEXPR) {}
 
-    ~NoExpr() override {}
+    ExprResult visit(Codegen* gen);
 };
 
-struct CastNode : Node
+struct CastNode : ExprNode
 {
+    CastNode() : ExprNode(NodeType::CAST) {}
+
     Node* forward = nullptr;
 
     Type type;
 
-    virtual void visit(std::string* write) override;
-
-    ~CastNode() override { if (forward) delete forward; }   
+    ExprResult visit(Codegen* gen);
 };
 
-struct UnaryOpNode : Node
+struct UnaryOpNode : ExprNode
 {
+    UnaryOpNode() : ExprNode(NodeType::UNARY) {}
+
     Node* forward = nullptr;
 
     NodeKind op;
 
-    virtual void visit(std::string* write) override;
-
-    ~UnaryOpNode() override
-    {
-        if (forward) delete forward;
-    }
+    ExprResult visit(Codegen* gen);
 };
 
-struct BinaryOpNode : Node
+struct BinaryOpNode : ExprNode
 {
+    BinaryOpNode() : ExprNode(NodeType::BINARY) {}
+
     Node* lhs = nullptr;
     Node* rhs = nullptr;
 
     NodeKind op;
 
-    virtual void visit(std::string* write) override;
-    
-    ~BinaryOpNode() override 
-    {
-        if (lhs) delete lhs;
-        if (rhs) delete rhs;
-    }
+    // Set by check_types, the type both operands are converted to before an arithmetic op or comparison
+    Type convert_to = {TypeKind::NULLTP, 0};
+
+    ExprResult visit(Codegen* gen);
 };
 
-struct TernNode : Node
+struct TernNode : ExprNode
 {
+    TernNode() : ExprNode(NodeType::TERN) {}
+
     Node* condition = nullptr;
     Node* lhs = nullptr;
     Node* rhs = nullptr;
@@ -214,48 +266,54 @@ struct TernNode : Node
     // This is used because we can make AND and OR into ternary, and this makes the output a boolean value like && and ||
     bool forceboolout = false;
 
-    virtual void visit(std::string* write) override;
+    // Set by check_types, the type both branches are converted to
+    Type convert_to = {TypeKind::NULLTP, 0};
 
-    ~TernNode() override
-    {
-        if (condition) delete condition;
-        if (lhs) delete lhs;
-        if (rhs) delete rhs;
-    }
+    ExprResult visit(Codegen* gen);
 };
 
-struct LiteralNode : Node
+struct LiteralNode : ExprNode
 {
+    LiteralNode() : ExprNode(NodeType::LITERAL) {}
+
     Type type;
-    Token value;
+    LiteralValue value;
 
-    virtual void visit(std::string* write) override;
-    
-    ~LiteralNode() override {}
+    ExprResult visit(Codegen* gen);
 };
 
-struct VarNode : Node
+struct VarNode : ExprNode
 {
+    VarNode() : ExprNode(NodeType::VAR) {}
+
     Token name; 
 
-    virtual void visit(std::string* write) override;
+    // Set by resolve_names, a local is the slot it was declared in and a global is its symtable entry
+    Location loc = Location::LOCAL;
+    uint32_t slot = 0;
+    GlobalEntry* global = nullptr;
 
-    ~VarNode() override {}
+    ExprResult visit(Codegen* gen);
 };
 
-struct FuncallNode : Node
+struct FuncallNode : ExprNode
 {
+    FuncallNode() : ExprNode(NodeType::FUNCALL) {}
+
     Token name;
 
-    std::list<std::unique_ptr<Node>> args;
+    NodeList args;
 
-    virtual void visit(std::string* write) override;
+    // Set by resolve_names
+    FuncEntry* entry = nullptr;
 
-    ~FuncallNode() override {}
+    ExprResult visit(Codegen* gen);
 };
 
 struct DeclNode : Node
 {
+    DeclNode() : Node(NodeType::DECL) {}
+
     // Type of the variable that is being declared
     Type type; 
 
@@ -268,74 +326,109 @@ struct DeclNode : Node
     // Assignment expression if there is one
     Node* assign = nullptr;
 
-    virtual void visit(std::string* write) override;
-    void visit_symt() override;
-
-    ~DeclNode() override { if (assign) delete assign; }
+    // Set by resolve_names, same as for VarNode
+    Location loc = Location::GLOBAL;
+    uint32_t slot = 0;
+    GlobalEntry* global = nullptr;
+    // Also set by resolve_names for locals, the position in the frame (shared by locals whose scopes don't overlap)
+    // and if the local's address is taken anywhere
+    uint32_t frame = 0;
+    bool address_taken = false;
+
+    ExprResult visit(Codegen* gen);
+    void visit_symt();
 };
 
 // Node types for break and continue
-struct BreakNode : Node { virtual void visit(std::string* write) override; ~BreakNode() override {} };
-struct ContinueNode : Node { virtual void visit(std::string* write) override; ~ContinueNode() override {} };
+struct BreakNode : Node { BreakNode() : Node(NodeType::BREAK) {} ExprResult visit(Codegen* gen); };
+struct ContinueNode : Node { ContinueNode() : Node(NodeType::CONTINUE) {} ExprResult visit(Codegen* gen); };
 
 struct RetNode : Node
 {
+    RetNode() : Node(NodeType::RETURN) {}
+
     // The return value of the statement
     Node* value = nullptr;
 
     // Codegen
-    virtual void visit(std::string* write) override;
-
-    ~RetNode() override { if (value) delete value; };
+    ExprResult visit(Codegen* gen);
 };
 
 struct IfNode : Node
 {
+    IfNode() : Node(NodeType::IF) {}
+
     Node* condition = nullptr;
     Node* statement = nullptr;
     Node* else_stmt = nullptr;
 
-    virtual void visit(std::string* write) override;
-
-    ~IfNode() override
-    { 
-        if (condition) delete condition;
-        if (statement) delete statement;
-        if (else_stmt) delete else_stmt;
-    }
+    ExprResult visit(Codegen* gen);
 };
 
 struct ForNode : Node
 {
+    ForNode() : Node(NodeType::FOR) {}
+
     Node* initial = nullptr;
     Node* condition = nullptr;
     Node* end = nullptr;
     Node* statement = nullptr;
 
-    virtual void visit(std::string* write) override;
-
-    ~ForNode() override
-    { 
-        if (initial) delete initial;
-        if (condition) delete condition;
-        if (end) delete end;
-        if (statement) delete statement;
-    }
+    ExprResult visit(Codegen* gen);
 };
 
 struct WhileNode : Node
 {
+    WhileNode() : Node(NodeType::WHILE) {}
+
     Node* condition = nullptr;
     Node* statement = nullptr;
 
     // So I can reuse this for do, because do and while are very similar
     bool do_on = false;
 
-    virtual void visit(std::string* write) override;
+    ExprResult visit(Codegen* gen);
+};
+
+// Calls f with node cast to the struct it actually is
+// Passes dispatch through this instead of virtual functions, so small visitors can be inlined into the switch
+template <typename F>
+decltype(auto) visit_node(Node* node, F&& f)
+{
+    switch (node->node_type)
+    {
+        case NodeType::PROGRAM: return f(static_cast<ProgramNode*>(node));
+        case NodeType::ARG: return f(static_cast<ArgNode*>(node));
+        case NodeType::BLOCKSTMT: return f(static_cast<BlockStmtNode*>(node));
+        case NodeType::TERMCHECK: return f(static_cast<TerminatorCheckNode*>(node));
+        case NodeType::FUNCTION: return f(static_cast<FunctionNode*>(node));
+        case NodeType::NOEXPR: return f(static_cast<NoExpr*>(node));
+        case NodeType::CAST: return f(static_cast<CastNode*>(node));
+        case NodeType::UNARY: return f(static_cast<UnaryOpNode*>(node));
+        case NodeType::BINARY: return f(static_cast<BinaryOpNode*>(node));
+        case NodeType::TERN: return f(static_cast<TernNode*>(node));
+        case NodeType::LITERAL: return f(static_cast<LiteralNode*>(node));
+        case NodeType::VAR: return f(static_cast<VarNode*>(node));
+        case NodeType::FUNCALL: return f(static_cast<FuncallNode*>(node));
+        case NodeType::DECL: return f(static_cast<DeclNode*>(node));
+        case NodeType::BREAK: return f(static_cast<BreakNode*>(node));
+        case NodeType::CONTINUE: return f(static_cast<ContinueNode*>(node));
+        case NodeType::RETURN: return f(static_cast<RetNode*>(node));
+        case NodeType::IF: return f(static_cast<IfNode*>(node));
+        case NodeType::FOR: return f(static_cast<ForNode*>(node));
+        case NodeType::WHILE: return f(static_cast<WhileNode*>(node));
+        default: throw compiler_error("Invalid node type %d", (int) node->node_type);
+    }
+}
 
-    ~WhileNode() override
-    { 
-        if (condition) delete condition;
-        if (statement) delete statement;
+// Only the top level nodes take part in building the symtables
+inline void Node::visit_symt()
+{
+    switch (node_type)
+    {
+        case NodeType::PROGRAM: static_cast<ProgramNode*>(this)->visit_symt(); break;
+        case NodeType::FUNCTION: static_cast<FunctionNode*>(this)->visit_symt(); break;
+        case NodeType::DECL: static_cast<DeclNode*>(this)->visit_symt(); break;
+        default: break;
     }
-};
\ No newline at end of file
+}
@@ -4,80 +4,141 @@
 #include <iostream>
 #include <algorithm>
 #include <sstream>
-#include <unordered_map>
 #include <array>
 
 #include "util.h"
 #include "error/error.h"
 #include "type.h"
 
-// Precedence map for binary input operations
-std::unordered_map</* Binary operator */ TokenType, std::pair<size_t /* Precedence */, bool /* Left or right */ >> prec_map({
-    {TokenType::ADD, {6, 0}}, 
-    {TokenType::DASH, {6, 0}},
-    {TokenType::MUL, {7, 0}},
-    {TokenType::DIV, {7, 0}},
-    {TokenType::MOD, {7, 0}}, 
-    {TokenType::AND, {3, 0}},
-    {TokenType::OR, {2, 0}},
-    {TokenType::EQ, {4, 0}},
-    {TokenType::NOTEQ, {4, 0}},
-    {TokenType::LESS, {5, 0}},
-    {TokenType::LESSEQ, {5, 0}},
-    {TokenType::GREATER, {5, 0}},
-    {TokenType::GREATEREQ, {5, 0}},
-    {TokenType::TERN, {1, 1}},
-    {TokenType::ASSIGN, {0, 1}},
-});
+// Binding powers of the infix operators, a Pratt parser keeps folding operators into lhs while their left binding power
+// is at least the minimum it was called with, and parses their rhs with the right binding power
+// Left associative operators bind their rhs one tighter than themselves, right associative ones the same
+struct BindingPower
+{
+    // -1 if the token isn't an infix operator
+    int8_t left = -1;
+    int8_t right = -1;
+    NodeKind kind = NodeKind::NOKIND;
+};
+
+constexpr std::array<BindingPower, TOKEN_TYPES> make_infix_table()
+{
+    std::array<BindingPower, TOKEN_TYPES> table{};
+    auto set = [&](TokenType type, int8_t prec, bool right_assoc, NodeKind kind) {
+        table[(size_t) type] = {prec, (int8_t) (right_assoc ? prec : prec + 1), kind};
+    };
+
+    set(TokenType::ASSIGN, 0, true, NodeKind::ASSIGN);
+    set(TokenType::TERN, 1, true, NodeKind::TERN);
+    set(TokenType::OR, 2, false, NodeKind::OR);
+    set(TokenType::AND, 3, false, NodeKind::AND);
+    set(TokenType::EQ, 4, false, NodeKind::EQ);
+    set(TokenType::NOTEQ, 4, false, NodeKind::NOTEQ);
+    set(TokenType::LESS, 5, false, NodeKind::LESS);
+    set(TokenType::LESSEQ, 5, false, NodeKind::LESSEQ);
+    set(TokenType::GREATER, 5, false, NodeKind::GREATER);
+    set(TokenType::GREATEREQ, 5, false, NodeKind::GREATEREQ);
+    set(TokenType::ADD, 6, false, NodeKind::ADD);
+    set(TokenType::DASH, 6, false, NodeKind::SUB);
+    set(TokenType::MUL, 7, false, NodeKind::MUL);
+    set(TokenType::DIV, 7, false, NodeKind::DIV);
+    set(TokenType::MOD, 7, false, NodeKind::MOD);
+
+    return table;
+}
+
+constexpr std::array<BindingPower, TOKEN_TYPES> infix_ops = make_infix_table();
+
+// Node kinds of the prefix operators, NOKIND if the token isn't one
+constexpr std::array<NodeKind, TOKEN_TYPES> make_prefix_table()
+{
+    std::array<NodeKind, TOKEN_TYPES> table{};
+    table.fill(NodeKind::NOKIND);
+
+    table[(size_t) TokenType::NOT] = NodeKind::NOT;
+    table[(size_t) TokenType::DASH] = NodeKind::NEG;
+    table[(size_t) TokenType::BITCOMPL] = NodeKind::BITCOMPL;
+    table[(size_t) TokenType::INC] = NodeKind::PREFIXINC;
+    table[(size_t) TokenType::DEC] = NodeKind::PREFIXDEC;
+    table[(size_t) TokenType::MUL] = NodeKind::DEREF;
+    table[(size_t) TokenType::ADDR] = NodeKind::ADDR;
+
+    return table;
+}
+
+constexpr std::array<NodeKind, TOKEN_TYPES> prefix_ops = make_prefix_table();
+
+// Lists are collected on these scratch stacks while they are parsed, nested lists go on top of the outer one
+// Once a list is done it is copied into the arena and popped off
+std::vector<Node*> node_scratch;
+std::vector<ArgNode> arg_scratch;
+
+template <typename T>
+ArenaList<T> finish_list(std::vector<T>& scratch, size_t start)
+{
+    ArenaList<T> list = node_arena.make_list(scratch.data() + start, scratch.size() - start);
+    scratch.resize(start);
+    return list;
+}
 
 // Function definitions not all are needed, but they are all here (some are needed)
 ProgramNode* parse_program(Tokenizer& tokens);
-FunctionNode* parse_function(Tokenizer& tokens);
+FunctionNode* parse_function(Tokenizer& tokens, const TypeSpec& spec);
 Node* parse_blk_item(Tokenizer& tokens);
 Node* parse_statement(Tokenizer& tokens);
 Node* parse_exp(Tokenizer& tokens, size_t min_prec);
 Node* parse_atom(Tokenizer& tokens);
 Node* parse_base_atom(Tokenizer& tokens);
-DeclNode* do_decl(Tokenizer& tokens);
-bool check_type(Tokenizer& tokens);
+DeclNode* do_decl(Tokenizer& tokens, const TypeSpec& spec);
 
 ProgramNode* parse_program(Tokenizer& tokens)
 {
-    ProgramNode* current = new ProgramNode();
+    ProgramNode* current = node_arena.make<ProgramNode>();
 
-    while (tokens.getPos() < tokens.size())
-    {
-        size_t before_type = tokens.getPos();
-        gen_expl_type(tokens, {TypeKind::NULLTP, 0});
-        size_t after_type = tokens.getPos();
-        tokens.setPos(before_type);
+    // A failed parse can leave items on the scratch stacks
+    node_scratch.clear();
+    arg_scratch.clear();
 
-        // FIX FINDING PARENTHESIS FOR FUNCTION
-        if (tokens.cur(after_type + 1 - before_type).type == TokenType::OPAREN)
-        {
-            // A program node will create a function subnode
-            current->forward.emplace_back(parse_function(tokens));
-            tokens.inc();
-        }
-        else 
+    try
+    {
+        while (!tokens.end())
         {
-            // Is declaration
-            current->forward.emplace_back(do_decl(tokens));
-            if (tokens.cur().type != TokenType::SEMI) throw compiler_error("Expected end of declaration %s", tokens.cur().value.c_str());
-            tokens.inc();
+            TypeSpec spec = peek_type(tokens);
+
+            // FIX FINDING PARENTHESIS FOR FUNCTION
+            if (tokens.cur(spec.length + 1).type == TokenType::OPAREN)
+            {
+                // A program node will create a function subnode
+                node_scratch.push_back(parse_function(tokens, spec));
+                tokens.inc();
+            }
+            else 
+            {
+                // Is declaration
+                node_scratch.push_back(do_decl(tokens, spec));
+                if (tokens.cur().type != TokenType::SEMI) throw compiler_error("Expected end of declaration %s", std::string(tokens.cur().value).c_str());
+                tokens.inc();
+            }
         }
+
+        current->forward = finish_list(node_scratch, 0);
+    }
+    catch (compiler_error& e)
+    {
+        // Give the error the location of the token the parser stopped at
+        throw compiler_error("%u:%u: %s", tokens.cur().loc.line, tokens.cur().loc.col, e.what());
     }
 
     return current;
 }
 
-FunctionNode* parse_function(Tokenizer& tokens)
+FunctionNode* parse_function(Tokenizer& tokens, const TypeSpec& spec)
 {   
-    FunctionNode* current = new FunctionNode;
+    FunctionNode* current = node_arena.make<FunctionNode>();
 
-    Type type = gen_expl_type(tokens, {TypeKind::NULLTP, 0});
+    Type type = take_type(tokens, spec);
     if (type.t_kind == TypeKind::NULLTP) throw compiler_error("Expected return type of function before identifier");
-    if (tokens.cur().type != TokenType::IDENT) throw compiler_error("Expected identifier or \'(\' before \'%s\' token", tokens.cur().value.c_str());
+    if (tokens.cur().type != TokenType::IDENT) throw compiler_error("Expected identifier or \'(\' before \'%s\' token", std::string(tokens.cur().value).c_str());
 
     current->type = type;
     current->name = tokens.cur();
@@ -87,18 +148,19 @@ FunctionNode* parse_function(Tokenizer& tokens)
     if (tokens.cur().type != TokenType::OPAREN) throw compiler_error("Invalid function declaration");
     tokens.inc();
 
+    size_t args_start = arg_scratch.size();
     if (tokens.cur().type == TokenType::CPAREN) tokens.inc();
     else
     {
         while (true)
         {
-            current->args.emplace_back();
-            Type type = gen_expl_type(tokens, {TypeKind::NULLTP, 0});
+            arg_scratch.emplace_back();
+            Type type = gen_expl_type(tokens);
             if (!type) throw compiler_error("Expected type of arg before identifier");
             if (tokens.cur().type != TokenType::IDENT) throw compiler_error("Expected identifier as argument");
             
-            current->args.back().type = type;
-            current->args.back().tok = tokens.cur();
+            arg_scratch.back().type = type;
+            arg_scratch.back().tok = tokens.cur();
 
             tokens.inc();
 
@@ -112,6 +174,7 @@ FunctionNode* parse_function(Tokenizer& tokens)
             tokens.inc();
         }
     }
+    current->args = finish_list(arg_scratch, args_start);
 
     if (tokens.cur().type == TokenType::SEMI) return current;
 
@@ -120,23 +183,26 @@ FunctionNode* parse_function(Tokenizer& tokens)
     tokens.inc();
 
     // Loop through func (which is a list of statements), if } is found end the loop
+    size_t start = node_scratch.size();
     while (true) 
     {
         tokens.check("Invalid function declaration");
 
         // Parse blkitem should point to next token 
-        if (tokens.cur().type == TokenType::CBRACKET) return current;
-        current->statements.forward.emplace_back(parse_blk_item(tokens));
+        if (tokens.cur().type == TokenType::CBRACKET) break;
+        node_scratch.push_back(parse_blk_item(tokens));
     }
+    current->statements.forward = finish_list(node_scratch, start);
 
     return current;
 }
 
 // Check for declaration, used for blkitems, global scope, and loops
-DeclNode* do_decl(Tokenizer& tokens)
+// The type of the declaration has already been scanned by the caller
+DeclNode* do_decl(Tokenizer& tokens, const TypeSpec& spec)
 {
-    DeclNode* decl = new DeclNode;
-    decl->type = gen_expl_type(tokens, {TypeKind::NULLTP, 0});
+    DeclNode* decl = node_arena.make<DeclNode>();
+    decl->type = take_type(tokens, spec);
     decl->name = tokens.cur();
     tokens.inc();
 
@@ -151,22 +217,15 @@ DeclNode* do_decl(Tokenizer& tokens)
     return decl;
 }
 
-bool check_type(Tokenizer& tokens)
-{
-    size_t pos = tokens.getPos();
-    bool rval = gen_expl_type(tokens, {TypeKind::NULLTP, 0}).t_kind != TypeKind::NULLTP;
-    tokens.setPos(pos);
-    return rval;
-}
-
 // Make sure declarations arn't in if statements that don't create a new scope
 // So there is no if variable creation
 Node* parse_blk_item(Tokenizer& tokens)
 {
     // Check for declaration
-    if (check_type(tokens))
+    TypeSpec spec = peek_type(tokens);
+    if (spec.starts_type())
     {
-        DeclNode* decl = do_decl(tokens);
+        DeclNode* decl = do_decl(tokens, spec);
         if (tokens.cur().type != TokenType::SEMI) throw compiler_error("Expected end of declaration");
         tokens.inc();
         return decl;
@@ -180,7 +239,7 @@ Node* parse_statement(Tokenizer& tokens)
     // Return statement
     if (tokens.cur().type == TokenType::RET)
     {
-        RetNode* rnode = new RetNode;
+        RetNode* rnode = node_arena.make<RetNode>();
         tokens.inc();
 
         rnode->value = parse_exp(tokens, 0);
@@ -194,7 +253,7 @@ Node* parse_statement(Tokenizer& tokens)
     // If statement
     if (tokens.cur().type == TokenType::IF)
     {
-        IfNode* inode = new IfNode;
+        IfNode* inode = node_arena.make<IfNode>();
         tokens.inc();
         if (tokens.cur().type != TokenType::OPAREN) throw compiler_error("Expected '(' before expr %d", (size_t) tokens.cur().type);
         tokens.inc();
@@ -208,7 +267,7 @@ Node* parse_statement(Tokenizer& tokens)
 
         // Get statement to execute if condition is true
         // Wrap in BlockStmtNode to cover edge cases
-        TerminatorCheckNode* statement = new TerminatorCheckNode;
+        TerminatorCheckNode* statement = node_arena.make<TerminatorCheckNode>();
         statement->forward = parse_statement(tokens);
         inode->statement = statement;
 
@@ -218,7 +277,7 @@ Node* parse_statement(Tokenizer& tokens)
             tokens.inc();
             // Get statement to execute if condition is false (else)
             // Wrap in BlockStmtNode to cover edge cases
-            TerminatorCheckNode* statement = new TerminatorCheckNode;
+            TerminatorCheckNode* statement = node_arena.make<TerminatorCheckNode>();
             statement->forward = parse_statement(tokens);
             inode->else_stmt = statement;
         }
@@ -227,15 +286,16 @@ Node* parse_statement(Tokenizer& tokens)
     }
     else if (tokens.cur().type == TokenType::FOR)
     {
-        ForNode* fnode = new ForNode;
+        ForNode* fnode = node_arena.make<ForNode>();
         tokens.inc();
         if (tokens.cur().type != TokenType::OPAREN) throw compiler_error("Expected '(' before expr %d", (size_t) tokens.cur().type);
         tokens.inc();
 
         // Parse initial statement
-        if (check_type(tokens)) 
+        TypeSpec spec = peek_type(tokens);
+        if (spec.starts_type()) 
         {
-            fnode->initial = do_decl(tokens);
+            fnode->initial = do_decl(tokens, spec);
             if (tokens.cur().type != TokenType::SEMI) throw compiler_error("Expected end of expression");
             tokens.inc();
         }
@@ -259,13 +319,13 @@ Node* parse_statement(Tokenizer& tokens)
         }
         else
         {
-            fnode->end = new NoExpr;
+            fnode->end = node_arena.make<NoExpr>();
             tokens.inc();
         }
 
         // Get statement to execute if condition is true
         // Wrap in BlockStmtNode to cover edge cases
-        TerminatorCheckNode* statement = new TerminatorCheckNode;
+        TerminatorCheckNode* statement = node_arena.make<TerminatorCheckNode>();
         statement->forward = parse_statement(tokens);
         fnode->statement = statement;
 
@@ -273,7 +333,7 @@ Node* parse_statement(Tokenizer& tokens)
     }
     else if (tokens.cur().type == TokenType::WHILE)
     {   
-        WhileNode* wnode = new WhileNode;
+        WhileNode* wnode = node_arena.make<WhileNode>();
         tokens.inc();
         if (tokens.cur().type != TokenType::OPAREN) throw compiler_error("Expected '(' before expr %d", (size_t) tokens.cur().type);
         tokens.inc();
@@ -289,7 +349,7 @@ Node* parse_statement(Tokenizer& tokens)
 
         // Get statement to execute if condition is true
         // Wrap in BlockStmtNode to cover edge cases
-        TerminatorCheckNode* statement = new TerminatorCheckNode;
+        TerminatorCheckNode* statement = node_arena.make<TerminatorCheckNode>();
         statement->forward = parse_statement(tokens);
         wnode->statement = statement;
 
@@ -297,13 +357,13 @@ Node* parse_statement(Tokenizer& tokens)
     }
     else if (tokens.cur().type == TokenType::DO)
     {
-        WhileNode* wnode = new WhileNode;
+        WhileNode* wnode = node_arena.make<WhileNode>();
         wnode->do_on = true;
         tokens.inc();
 
         // Get statement to execute if condition is true
         // Wrap in BlockStmtNode to cover edge cases
-        TerminatorCheckNode* statement = new TerminatorCheckNode;
+        TerminatorCheckNode* statement = node_arena.make<TerminatorCheckNode>();
         statement->forward = parse_statement(tokens);
         wnode->statement = statement;
 
@@ -332,7 +392,7 @@ Node* parse_statement(Tokenizer& tokens)
         if (tokens.cur().type != TokenType::SEMI) throw compiler_error("Expected end of statement");
         tokens.inc();
 
-        return new BreakNode;
+        return node_arena.make<BreakNode>();
     }
     else if (tokens.cur().type == TokenType::CONTINUE)
     {
@@ -340,16 +400,17 @@ Node* parse_statement(Tokenizer& tokens)
         if (tokens.cur().type != TokenType::SEMI) throw compiler_error("Expected end of statement");
         tokens.inc();
 
-        return new ContinueNode;
+        return node_arena.make<ContinueNode>();
     }
     else if (tokens.cur().type == TokenType::OBRACKET)
     {
-        BlockStmtNode* bnode = new BlockStmtNode;
+        BlockStmtNode* bnode = node_arena.make<BlockStmtNode>();
         tokens.inc();
 
         if (tokens.cur().type == TokenType::CBRACKET) return bnode;
 
         // Loop through func (which is a list of statements), if } is found end the loop
+        size_t start = node_scratch.size();
         while (true) 
         {
             tokens.check("Invalid block statement");
@@ -358,8 +419,9 @@ Node* parse_statement(Tokenizer& tokens)
             if (tokens.cur().type == TokenType::CBRACKET) break;
 
             // This is evaluated in the parse_statement function
-            bnode->forward.emplace_back(parse_blk_item(tokens));
+            node_scratch.push_back(parse_blk_item(tokens));
         }
+        bnode->forward = finish_list(node_scratch, start);
 
         tokens.inc();
 
@@ -379,34 +441,18 @@ Node* parse_statement(Tokenizer& tokens)
 
 Node* parse_exp(Tokenizer& tokens, size_t min_prec)
 {   
-    if (tokens.cur().type == TokenType::SEMI) return new NoExpr;
+    if (tokens.cur().type == TokenType::SEMI) return node_arena.make<NoExpr>();
 
     Node* lhs = parse_atom(tokens);
 
     while (true)
     {
-        if (!prec_map.contains(tokens.cur().type) || prec_map[tokens.cur().type].first < min_prec) break;
-
-        std::unordered_map<TokenType, NodeKind> convert({
-            {TokenType::ADD, NodeKind::ADD},
-            {TokenType::DASH, NodeKind::SUB},
-            {TokenType::MUL, NodeKind::MUL},
-            {TokenType::DIV, NodeKind::DIV}, 
-            {TokenType::MOD, NodeKind::MOD}, 
-            {TokenType::AND, NodeKind::AND},
-            {TokenType::OR, NodeKind::OR},
-            {TokenType::EQ, NodeKind::EQ},
-            {TokenType::NOTEQ, NodeKind::NOTEQ},
-            {TokenType::LESS, NodeKind::LESS},
-            {TokenType::LESSEQ, NodeKind::LESSEQ},
-            {TokenType::GREATER, NodeKind::GREATER},
-            {TokenType::GREATEREQ, NodeKind::GREATEREQ}, 
-            {TokenType::ASSIGN, NodeKind::ASSIGN}, 
-        });
-
-        if (tokens.cur().type == TokenType::TERN)
+        const BindingPower& power = infix_ops[(size_t) tokens.cur().type];
+        if (power.left < 0 || (size_t) power.left < min_prec) break;
+
+        if (power.kind == NodeKind::TERN)
         {
-            TernNode* tern = new TernNode;
+            TernNode* tern = node_arena.make<TernNode>();
             tern->condition = lhs;
             lhs = tern;
             tern->forceboolout = false;
@@ -420,55 +466,51 @@ Node* parse_exp(Tokenizer& tokens, size_t min_prec)
 
             tern->rhs = parse_exp(tokens, 0);
         }
-        else if (tokens.cur().type == TokenType::OR || tokens.cur().type == TokenType::AND)
+        else if (power.kind == NodeKind::OR || power.kind == NodeKind::AND)
         {
             // Build OR and AND as a ternary node because it is less code
-            TernNode* tern = new TernNode;
+            TernNode* tern = node_arena.make<TernNode>();
             tern->condition = lhs;
             lhs = tern;
             tern->forceboolout = true;
 
-            auto precAssoc = prec_map[tokens.cur().type];
-            size_t nextMinimumPrec = precAssoc.second ? precAssoc.first : precAssoc.first + 1;
-
-            if (tokens.cur().type == TokenType::OR)
+            if (power.kind == NodeKind::OR)
             {
-                LiteralNode* lhs = new LiteralNode;
+                LiteralNode* lhs = node_arena.make<LiteralNode>();
                 lhs->type = Type{TypeKind::BOOL, 1};
-                lhs->value = Token{TokenType::INTV, "1"};
+                lhs->value.kind = LiteralValue::INT;
+                lhs->value.i = 1;
 
                 tern->lhs = lhs;
                 tokens.inc();
                 if (tokens.cur().type == TokenType::SEMI) throw compiler_error("Expected expression before semicolon");
-                tern->rhs = parse_exp(tokens, nextMinimumPrec);
+                tern->rhs = parse_exp(tokens, power.right);
             }
             else
             {
-                LiteralNode* rhs = new LiteralNode;
+                LiteralNode* rhs = node_arena.make<LiteralNode>();
                 rhs->type = Type{TypeKind::BOOL, 1};
-                rhs->value = Token{TokenType::INTV, "0"};
+                rhs->value.kind = LiteralValue::INT;
+                rhs->value.i = 0;
 
                 tern->rhs = rhs;
                 tokens.inc();
                 if (tokens.cur().type == TokenType::SEMI) throw compiler_error("Expected expression before semicolon");
-                tern->lhs = parse_exp(tokens, nextMinimumPrec);
+                tern->lhs = parse_exp(tokens, power.right);
             }
         }
         else
         {
-            BinaryOpNode* rval = new BinaryOpNode;
+            BinaryOpNode* rval = node_arena.make<BinaryOpNode>();
             rval->lhs = lhs;
             lhs = rval;
 
-            rval->op = convert[tokens.cur().type];
-            auto precAssoc = prec_map[tokens.cur().type];
-
-            size_t nextMinimumPrec = precAssoc.second ? precAssoc.first : precAssoc.first + 1;
+            rval->op = power.kind;
 
             tokens.inc();
             if (tokens.cur().type == TokenType::SEMI) throw compiler_error("Expected expression before semicolon");
 
-            rval->rhs = parse_exp(tokens, nextMinimumPrec);
+            rval->rhs = parse_exp(tokens, power.right);
         }
     }
 
@@ -483,7 +525,7 @@ Node* parse_atom(Tokenizer& tokens)
         {
             case TokenType::INC:
             {
-                UnaryOpNode* op = new UnaryOpNode;
+                UnaryOpNode* op = node_arena.make<UnaryOpNode>();
                 op->op = NodeKind::POSTFIXINC;
                 op->forward = parse_base_atom(tokens);
                 tokens.inc();
@@ -491,7 +533,7 @@ Node* parse_atom(Tokenizer& tokens)
             }
             case TokenType::DEC:
             {
-                UnaryOpNode* op = new UnaryOpNode;
+                UnaryOpNode* op = node_arena.make<UnaryOpNode>();
                 op->op = NodeKind::POSTFIXDEC;
                 op->forward = parse_base_atom(tokens);
                 tokens.inc();
@@ -501,21 +543,23 @@ Node* parse_atom(Tokenizer& tokens)
             {
                 // Parse function
                 // Subnodes are args
-                FuncallNode* fn = new FuncallNode;
+                FuncallNode* fn = node_arena.make<FuncallNode>();
 
                 fn->name = tokens.cur();
                 
                 tokens.inc();
                 tokens.inc();
 
+                size_t start = node_scratch.size();
                 while (tokens.cur().type != TokenType::CPAREN)
                 {
-                    fn->args.emplace_back(parse_exp(tokens, 0));
+                    node_scratch.push_back(parse_exp(tokens, 0));
 
                     if (tokens.cur().type == TokenType::CPAREN) break;
                     if (tokens.cur().type != TokenType::COMMA) throw compiler_error("Expected comma before next argument");
                     tokens.inc();
                 }
+                fn->args = finish_list(node_scratch, start);
 
                 tokens.inc();
                 return fn;
@@ -531,27 +575,19 @@ Node* parse_base_atom(Tokenizer& tokens)
     if (tokens.cur().type == TokenType::OPAREN) 
     {
         tokens.inc();
-        size_t save_pos = tokens.getPos();
-        Node* exp = nullptr;
 
-        // Annoying hack because gen_expl_type can throw errors so they are caught here
-        // May come up with a better error handling method for gen_expl_type
-        try
+        // A valid type followed by ')' is a cast, anything else is a parenthesised expression
+        TypeSpec spec = peek_type(tokens);
+        if (spec.is_type() && tokens.cur(spec.length).type == TokenType::CPAREN)
         {
-            Type type = gen_expl_type(tokens, {TypeKind::NULLTP, 0});
-            if (tokens.cur().type != TokenType::CPAREN) throw compiler_error("Unmatched parenthesis \'(\'");
-            tokens.inc();
-            CastNode* cast = new CastNode;
-            cast->type = type;
+            tokens.setPos(tokens.getPos() + spec.length + 1);
+            CastNode* cast = node_arena.make<CastNode>();
+            cast->type = spec.type;
             cast->forward = parse_exp(tokens, 0);
             return cast;
         }
-        catch (compiler_error& e)
-        {
-            tokens.setPos(save_pos);
-            exp = parse_exp(tokens, 0);
-        }
 
+        Node* exp = parse_exp(tokens, 0);
         if (tokens.cur().type != TokenType::CPAREN) throw compiler_error("Unmatched parenthesis \'(\'");
         else 
         {
@@ -562,12 +598,13 @@ Node* parse_base_atom(Tokenizer& tokens)
     else
     {
         size_t pos = tokens.getPos();
-        Type type = gen_const_type(tokens);
+        LiteralValue value;
+        Type type = gen_const_type(tokens, value);
         if (type.t_kind != TypeKind::NULLTP) 
         {
-            LiteralNode* lit = new LiteralNode;
+            LiteralNode* lit = node_arena.make<LiteralNode>();
             lit->type = type;
-            lit->value = tokens.cur();    
+            lit->value = value;
             tokens.inc();
             return lit;
         }
@@ -577,27 +614,18 @@ Node* parse_base_atom(Tokenizer& tokens)
 
             if (tokens.cur().type == TokenType::IDENT)
             {
-                VarNode* var = new VarNode;
+                VarNode* var = node_arena.make<VarNode>();
                 var->name = tokens.cur();
                 tokens.inc();
                 return var;
             }
             else 
             {
-                UnaryOpNode* op = new UnaryOpNode;
-
-                std::unordered_map<TokenType, NodeKind> convert({
-                    {TokenType::NOT, NodeKind::NOT},
-                    {TokenType::DASH, NodeKind::NEG},
-                    {TokenType::BITCOMPL, NodeKind::BITCOMPL},
-                    {TokenType::INC, NodeKind::PREFIXINC},
-                    {TokenType::DEC, NodeKind::PREFIXDEC},
-                    {TokenType::MUL, NodeKind::DEREF},
-                    {TokenType::ADDR, NodeKind::ADDR},
-                });
-
-                if (!convert.contains(tokens.cur().type)) throw compiler_error("Couldn't build an atom from: %s", tokens.cur().value.c_str()); 
-                op->op = convert[tokens.cur().type];
+                NodeKind kind = prefix_ops[(size_t) tokens.cur().type];
+                if (kind == NodeKind::NOKIND) throw compiler_error("Couldn't build an atom from: %s", std::string(tokens.cur().value).c_str()); 
+
+                UnaryOpNode* op = node_arena.make<UnaryOpNode>();
+                op->op = kind;
                 tokens.inc();
     
                 op->forward = parse_atom(tokens);
@@ -607,7 +635,7 @@ Node* parse_base_atom(Tokenizer& tokens)
         }
     }
 
-    throw compiler_error("Couldn't build an atom from: %s", tokens.cur().value.c_str());
+    throw compiler_error("Couldn't build an atom from: %s", std::string(tokens.cur().value).c_str());
 
     return nullptr;
 }
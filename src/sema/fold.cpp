@@ -0,0 +1,346 @@
+#include "fold.h"
+
+#include "error/error.h"
+
+// std
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+
+bool is_number(Type type)
+{
+    return !type.num_pointers && type.t_kind != TypeKind::NULLTP;
+}
+
+LiteralNode* as_literal(Node* node)
+{
+    return node && node->node_type == NodeType::LITERAL ? static_cast<LiteralNode*>(node) : nullptr;
+}
+
+Node* make_literal(Type type, LiteralValue value)
+{
+    LiteralNode* node = node_arena.make<LiteralNode>();
+    node->type = type;
+    node->expr_type = type;
+    node->value = normalize_literal(type, value);
+    return node;
+}
+
+// An arithmetic op on two constants of type, none where the instruction has no defined result (division by zero, or
+// the most negative value divided by -1)
+LiteralValue fold_arith(NodeKind op, Type type, LiteralValue a, LiteralValue b)
+{
+    LiteralValue out;
+    if (type.t_kind == TypeKind::FLOAT)
+    {
+        out.kind = LiteralValue::FLOAT;
+        // A float op is done in float, so its result is rounded once
+        if (type.size == 4)
+        {
+            float x = a.f, y = b.f;
+            switch (op)
+            {
+                case NodeKind::ADD: out.f = x + y; break;
+                case NodeKind::SUB: out.f = x - y; break;
+                case NodeKind::MUL: out.f = x * y; break;
+                case NodeKind::DIV: out.f = x / y; break;
+                default: out.f = std::fmod(x, y); break;
+            }
+        }
+        else
+        {
+            switch (op)
+            {
+                case NodeKind::ADD: out.f = a.f + b.f; break;
+                case NodeKind::SUB: out.f = a.f - b.f; break;
+                case NodeKind::MUL: out.f = a.f * b.f; break;
+                case NodeKind::DIV: out.f = a.f / b.f; break;
+                default: out.f = std::fmod(a.f, b.f); break;
+            }
+        }
+        return out;
+    }
+
+    // Integers wrap, so they are added and multiplied unsigned and truncated to the type after
+    out.kind = LiteralValue::INT;
+    uint64_t x = a.i, y = b.i;
+    switch (op)
+    {
+        case NodeKind::ADD: out.i = x + y; break;
+        case NodeKind::SUB: out.i = x - y; break;
+        case NodeKind::MUL: out.i = x * y; break;
+        default:
+        {
+            if (y == 0) return {};
+            if (type.t_kind == TypeKind::UNSIGNED)
+            {
+                out.i = op == NodeKind::DIV ? x / y : x % y;
+                break;
+            }
+
+            int64_t min = type.size == 8 ? INT64_MIN : -((int64_t) 1 << (type.size * 8 - 1));
+            if (a.i == min && b.i == -1) return {};
+            out.i = op == NodeKind::DIV ? a.i / b.i : a.i % b.i;
+            break;
+        }
+    }
+    return normalize_literal(type, out);
+}
+
+// A comparison of two constants of type, floats compare ordered like the predicates codegen uses
+LiteralValue fold_compare(NodeKind op, Type type, LiteralValue a, LiteralValue b)
+{
+    bool result;
+    if (type.t_kind == TypeKind::FLOAT)
+    {
+        switch (op)
+        {
+            case NodeKind::EQ: result = a.f == b.f; break;
+            case NodeKind::NOTEQ: result = a.f < b.f || a.f > b.f; break;
+            case NodeKind::GREATER: result = a.f > b.f; break;
+            case NodeKind::GREATEREQ: result = a.f >= b.f; break;
+            case NodeKind::LESS: result = a.f < b.f; break;
+            default: result = a.f <= b.f; break;
+        }
+    }
+    else if (type.t_kind == TypeKind::UNSIGNED)
+    {
+        uint64_t x = a.i, y = b.i;
+        switch (op)
+        {
+            case NodeKind::EQ: result = x == y; break;
+            case NodeKind::NOTEQ: result = x != y; break;
+            case NodeKind::GREATER: result = x > y; break;
+            case NodeKind::GREATEREQ: result = x >= y; break;
+            case NodeKind::LESS: result = x < y; break;
+            default: result = x <= y; break;
+        }
+    }
+    else
+    {
+        switch (op)
+        {
+            case NodeKind::EQ: result = a.i == b.i; break;
+            case NodeKind::NOTEQ: result = a.i != b.i; break;
+            case NodeKind::GREATER: result = a.i > b.i; break;
+            case NodeKind::GREATEREQ: result = a.i >= b.i; break;
+            case NodeKind::LESS: result = a.i < b.i; break;
+            default: result = a.i <= b.i; break;
+        }
+    }
+
+    LiteralValue out;
+    out.kind = LiteralValue::INT;
+    out.i = result;
+    return out;
+}
+
+class Folder
+{
+private:
+    // The value of every const local of the current function that was initialized with a constant, by slot
+    std::vector<LiteralValue> const_locals;
+
+    void fold_list(NodeList& nodes)
+    {
+        for (Node*& node : nodes) node = fold(node);
+    }
+
+    // Folds inside a node that has to stay an lvalue, but keeps the node itself
+    void fold_lvalue(Node* node)
+    {
+        fold(node);
+    }
+public:
+    // Folds node and returns what replaces it, the node itself if it isn't a constant
+    Node* fold(Node* node)
+    {
+        if (!node) return nullptr;
+        return visit_node(node, [&](auto* n) -> Node* { return fold_node(n); });
+    }
+
+    // Statements, only their expressions are folded
+
+    Node* fold_node(ProgramNode* node) { fold_list(node->forward); return node; }
+    Node* fold_node(BlockStmtNode* node) { fold_list(node->forward); return node; }
+
+    Node* fold_node(FunctionNode* node)
+    {
+        const_locals.assign(node->slot_count, {});
+        fold_list(node->statements.forward);
+        return node;
+    }
+
+    Node* fold_node(DeclNode* node)
+    {
+        node->assign = fold(node->assign);
+
+        // Its reads are the value it was initialized with if it can't be changed, a local whose address is taken
+        // can still be written through the pointer
+        LiteralNode* literal = as_literal(node->assign);
+        if (node->loc == Location::LOCAL && literal && node->type.is_const && !node->address_taken)
+        {
+            const_locals[node->slot] = convert_literal(literal->value, literal->type, node->type);
+        }
+        return node;
+    }
+
+    Node* fold_node(TerminatorCheckNode* node) { node->forward = fold(node->forward); return node; }
+    Node* fold_node(RetNode* node) { node->value = fold(node->value); return node; }
+
+    Node* fold_node(IfNode* node)
+    {
+        node->condition = fold(node->condition);
+        node->statement = fold(node->statement);
+        node->else_stmt = fold(node->else_stmt);
+        return node;
+    }
+
+    Node* fold_node(ForNode* node)
+    {
+        node->initial = fold(node->initial);
+        node->condition = fold(node->condition);
+        node->statement = fold(node->statement);
+        node->end = fold(node->end);
+        return node;
+    }
+
+    Node* fold_node(WhileNode* node)
+    {
+        node->condition = fold(node->condition);
+        node->statement = fold(node->statement);
+        return node;
+    }
+
+    Node* fold_node(ArgNode* node) { return node; }
+    Node* fold_node(BreakNode* node) { return node; }
+    Node* fold_node(ContinueNode* node) { return node; }
+
+    // Expressions
+
+    Node* fold_node(NoExpr* node) { return node; }
+    Node* fold_node(LiteralNode* node) { return node; }
+    Node* fold_node(FuncallNode* node) { fold_list(node->args); return node; }
+
+    Node* fold_node(VarNode* node)
+    {
+        if (node->loc != Location::LOCAL || !const_locals[node->slot]) return node;
+        return make_literal(node->expr_type, const_locals[node->slot]);
+    }
+
+    Node* fold_node(CastNode* node)
+    {
+        node->forward = fold(node->forward);
+        LiteralNode* literal = as_literal(node->forward);
+        if (!literal) return node;
+
+        LiteralValue value = convert_literal(literal->value, literal->type, node->type);
+        return value ? make_literal(node->type, value) : node;
+    }
+
+    Node* fold_node(UnaryOpNode* node)
+    {
+        if (node->op != NodeKind::NEG && node->op != NodeKind::BITCOMPL && node->op != NodeKind::NOT)
+        {
+            fold_lvalue(node->forward);
+            return node;
+        }
+
+        node->forward = fold(node->forward);
+        LiteralNode* literal = as_literal(node->forward);
+        if (!literal || !is_number(literal->type)) return node;
+
+        bool is_float = literal->type.t_kind == TypeKind::FLOAT;
+        LiteralValue value = normalize_literal(literal->type, literal->value);
+        LiteralValue out;
+        out.kind = LiteralValue::INT;
+        switch (node->op)
+        {
+            case NodeKind::NEG:
+                if (is_float)
+                {
+                    out.kind = LiteralValue::FLOAT;
+                    out.f = -value.f;
+                }
+                else out.i = 0 - (uint64_t) value.i;
+                break;
+            case NodeKind::BITCOMPL:
+                // Codegen reports the error for a float
+                if (is_float) return node;
+                out.i = ~value.i;
+                break;
+            default:
+                // A NaN isn't equal to zero, so !NaN is 0
+                out.i = is_float ? value.f == 0 : value.i == 0;
+                break;
+        }
+        return make_literal(node->expr_type, out);
+    }
+
+    Node* fold_node(BinaryOpNode* node)
+    {
+        bool is_arith = node->op == NodeKind::ADD || node->op == NodeKind::SUB || node->op == NodeKind::MUL || node->op == NodeKind::DIV || node->op == NodeKind::MOD;
+        bool is_cmp = node->op == NodeKind::EQ || node->op == NodeKind::NOTEQ || node->op == NodeKind::GREATER || node->op == NodeKind::GREATEREQ || node->op == NodeKind::LESS || node->op == NodeKind::LESSEQ;
+
+        if (!is_arith && !is_cmp)
+        {
+            fold_lvalue(node->lhs);
+            node->rhs = fold(node->rhs);
+            return node;
+        }
+
+        node->lhs = fold(node->lhs);
+        node->rhs = fold(node->rhs);
+        LiteralNode* lhs = as_literal(node->lhs);
+        LiteralNode* rhs = as_literal(node->rhs);
+        if (!lhs || !rhs || !is_number(node->convert_to)) return node;
+
+        LiteralValue a = convert_literal(lhs->value, lhs->type, node->convert_to);
+        LiteralValue b = convert_literal(rhs->value, rhs->type, node->convert_to);
+        if (!a || !b) return node;
+
+        LiteralValue out = is_arith ? fold_arith(node->op, node->convert_to, a, b) : fold_compare(node->op, node->convert_to, a, b);
+        return out ? make_literal(node->expr_type, out) : node;
+    }
+
+    Node* fold_node(TernNode* node)
+    {
+        node->condition = fold(node->condition);
+        node->lhs = fold(node->lhs);
+        node->rhs = fold(node->rhs);
+
+        LiteralNode* condition = as_literal(node->condition);
+        if (!condition) return node;
+        LiteralValue taken = convert_literal(condition->value, condition->type, {TypeKind::BOOL, 1});
+        if (!taken) return node;
+
+        // Only the branch that is taken is left, converted to the type both branches are
+        Node* branch = taken.i ? node->lhs : node->rhs;
+        if (LiteralNode* literal = as_literal(branch))
+        {
+            LiteralValue value = convert_literal(literal->value, literal->type, node->convert_to);
+            return value ? make_literal(node->convert_to, value) : node;
+        }
+
+        Type type = static_cast<ExprNode*>(branch)->expr_type;
+        if (type == node->convert_to) return branch;
+        // Pointer conversions are different for casts, so those stay ternaries
+        if (!is_number(type) || !is_number(node->convert_to)) return node;
+
+        CastNode* cast = node_arena.make<CastNode>();
+        cast->forward = branch;
+        cast->type = node->convert_to;
+        cast->expr_type = node->convert_to;
+        return cast;
+    }
+};
+
+}
+
+void fold_constants(Node* node)
+{
+    Folder().fold(node);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "node/node.h"
+
+// Replaces every expression made only of constants with the literal it evaluates to, and every read of a const local
+// initialized with a constant with that constant, so codegen emits a value instead of instructions for them
+// Folds in the types check_types gave the expressions, so a folded value is the one the instructions would compute
+// Runs after check_types
+void fold_constants(Node* node);
@@ -0,0 +1,179 @@
+#include "resolve.h"
+
+#include "symt/symt.h"
+#include "error/error.h"
+
+class Resolver
+{
+private:
+    // The slot of every local in scope by its symbol
+    ScopedTable<uint32_t> locals;
+
+    // Slots handed out in the current function, arguments take the first ones
+    uint32_t next_slot = 0;
+
+    // Frame positions of the locals in open scopes, a scope's positions are free again once it is left
+    // Locals with the same position never are in scope at the same time, so codegen can give them one stack slot
+    uint32_t next_frame = 0;
+    std::vector<uint32_t> frame_marks;
+
+    // The declaration of every slot of the current function, nullptr for arguments
+    std::vector<DeclNode*> slot_decls;
+
+    // How many loops the statement being resolved is in, break and continue need at least one
+    size_t loop_depth = 0;
+
+    void resolve_list(const NodeList& nodes)
+    {
+        for (Node* node : nodes) resolve(node);
+    }
+
+    void enter()
+    {
+        locals.enter();
+        frame_marks.push_back(next_frame);
+    }
+
+    void leave()
+    {
+        locals.leave();
+        next_frame = frame_marks.back();
+        frame_marks.pop_back();
+    }
+public:
+    void resolve(Node* node)
+    {
+        if (node) visit_node(node, [&](auto* n) { resolve(n); });
+    }
+
+    void resolve(ProgramNode* node)
+    {
+        locals.clear();
+        resolve_list(node->forward);
+    }
+
+    void resolve(FunctionNode* node)
+    {
+        node->entry = function_definitions.find(node->name.sym);
+        next_slot = 0;
+        next_frame = 0;
+        slot_decls.assign(node->args.size(), nullptr);
+
+        enter();
+        for (const ArgNode& arg : node->args) locals.declare(arg.tok.sym, next_slot++);
+        resolve_list(node->statements.forward);
+        leave();
+
+        node->slot_count = next_slot;
+    }
+
+    void resolve(BlockStmtNode* node)
+    {
+        enter();
+        resolve_list(node->forward);
+        leave();
+    }
+
+    void resolve(DeclNode* node)
+    {
+        SymbolId name = node->name.sym;
+        if (locals.depth() == 0)
+        {
+            node->loc = Location::GLOBAL;
+            node->global = global_definitions.find(name);
+        }
+        else
+        {
+            if (locals.declared_here(name)) throw compiler_error("Redefinition of local variable %s", symbol_name(name).data());
+            node->loc = Location::LOCAL;
+            node->slot = locals.declare(name, next_slot++);
+            node->frame = next_frame++;
+            slot_decls.push_back(node);
+        }
+        resolve(node->assign);
+    }
+
+    void resolve(VarNode* node)
+    {
+        SymbolId name = node->name.sym;
+        if (uint32_t* slot = locals.find(name))
+        {
+            node->loc = Location::LOCAL;
+            node->slot = *slot;
+        }
+        else if ((node->global = global_definitions.find(name)))
+        {
+            node->loc = Location::GLOBAL;
+        }
+        else throw compiler_error("Variable %s not declared\n", symbol_name(name).data());
+    }
+
+    void resolve(FuncallNode* node)
+    {
+        SymbolId name = node->name.sym;
+        node->entry = function_definitions.find(name);
+        if (!node->entry) throw compiler_error("Function %s not declared\n", symbol_name(name).data());
+        if (node->args.size() != node->entry->args.size()) throw compiler_error("Function %s called with wrong number of arguments\n", symbol_name(name).data());
+        resolve_list(node->args);
+    }
+
+    void resolve(ForNode* node)
+    {
+        // Same scopes as codegen, one for the initial clause and one for the rest
+        enter();
+        resolve(node->initial);
+        enter();
+        resolve(node->condition);
+        loop_depth++;
+        resolve(node->statement);
+        loop_depth--;
+        resolve(node->end);
+        leave();
+        leave();
+    }
+
+    void resolve(WhileNode* node)
+    {
+        resolve(node->condition);
+        loop_depth++;
+        resolve(node->statement);
+        loop_depth--;
+    }
+
+    void resolve(BreakNode*)
+    {
+        if (!loop_depth) throw compiler_error("Break statement not within a loop");
+    }
+
+    void resolve(ContinueNode*)
+    {
+        if (!loop_depth) throw compiler_error("Continue statement not within a loop");
+    }
+
+    void resolve(TerminatorCheckNode* node) { resolve(node->forward); }
+    void resolve(CastNode* node) { resolve(node->forward); }
+    void resolve(UnaryOpNode* node)
+    {
+        resolve(node->forward);
+        // A local whose address is taken has to stay in memory
+        if (node->op == NodeKind::ADDR && node->forward->node_type == NodeType::VAR)
+        {
+            VarNode* var = static_cast<VarNode*>(node->forward);
+            if (var->loc == Location::LOCAL && slot_decls[var->slot]) slot_decls[var->slot]->address_taken = true;
+        }
+    }
+    void resolve(BinaryOpNode* node) { resolve(node->lhs); resolve(node->rhs); }
+    void resolve(TernNode* node) { resolve(node->condition); resolve(node->lhs); resolve(node->rhs); }
+    void resolve(RetNode* node) { resolve(node->value); }
+    void resolve(IfNode* node) { resolve(node->condition); resolve(node->statement); resolve(node->else_stmt); }
+
+    // Nothing to bind
+    void resolve(ArgNode*) {}
+    void resolve(NoExpr*) {}
+    void resolve(LiteralNode*) {}
+};
+
+void resolve_names(Node* node)
+{
+    Resolver().resolve(node);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "node/node.h"
+
+// Binds every function, variable and call in the tree to its symtable entry or local slot, and checks calls against
+// the function they call, so codegen never has to look a name up
+// Runs after generate_symtables
+void resolve_names(Node* node);
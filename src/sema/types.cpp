@@ -0,0 +1,132 @@
+#include "types.h"
+
+#include "symt/symt.h"
+#include "error/error.h"
+
+// std
+#include <type_traits>
+#include <vector>
+
+class TypeChecker
+{
+private:
+    // Type of every local slot of the current function
+    std::vector<Type> locals;
+
+    void check_list(const NodeList& nodes)
+    {
+        for (Node* node : nodes) check(node);
+    }
+public:
+    // Checks node and returns its type, NULLTP for statements
+    Type check(Node* node)
+    {
+        if (!node) return {TypeKind::NULLTP, 0};
+        return visit_node(node, [&](auto* n) -> Type {
+            if constexpr (std::is_base_of_v<ExprNode, std::remove_pointer_t<decltype(n)>>) return n->expr_type = type_of(n);
+            else
+            {
+                check_stmt(n);
+                return {TypeKind::NULLTP, 0};
+            }
+        });
+    }
+
+    // Statements
+
+    void check_stmt(ProgramNode* node) { check_list(node->forward); }
+    void check_stmt(BlockStmtNode* node) { check_list(node->forward); }
+
+    void check_stmt(FunctionNode* node)
+    {
+        locals.assign(node->slot_count, {TypeKind::NULLTP, 0});
+        for (size_t i = 0; i < node->args.size(); i++) locals[i] = node->args[i].type;
+        check_list(node->statements.forward);
+    }
+
+    void check_stmt(DeclNode* node)
+    {
+        if (node->loc == Location::LOCAL) locals[node->slot] = node->type;
+        check(node->assign);
+    }
+
+    void check_stmt(TerminatorCheckNode* node) { check(node->forward); }
+    void check_stmt(RetNode* node) { check(node->value); }
+    void check_stmt(IfNode* node) { check(node->condition); check(node->statement); check(node->else_stmt); }
+    void check_stmt(ForNode* node) { check(node->initial); check(node->condition); check(node->statement); check(node->end); }
+    void check_stmt(WhileNode* node) { check(node->condition); check(node->statement); }
+    void check_stmt(ArgNode*) {}
+    void check_stmt(BreakNode*) {}
+    void check_stmt(ContinueNode*) {}
+
+    // Expressions, these give the same types codegen ends up with after emitting the node
+
+    Type type_of(NoExpr*) { return {TypeKind::NULLTP, 0}; }
+    Type type_of(LiteralNode* node) { return node->type; }
+    Type type_of(VarNode* node) { return node->loc == Location::LOCAL ? locals[node->slot] : node->global->type; }
+
+    Type type_of(CastNode* node)
+    {
+        check(node->forward);
+        return node->type;
+    }
+
+    Type type_of(FuncallNode* node)
+    {
+        check_list(node->args);
+        return node->entry->type;
+    }
+
+    Type type_of(UnaryOpNode* node)
+    {
+        Type type = check(node->forward);
+        switch (node->op)
+        {
+            case NodeKind::NOT: return {TypeKind::INT, 4};
+            case NodeKind::ADDR:
+                type.num_pointers++;
+                type.is_const = false;
+                return type;
+            case NodeKind::DEREF:
+                if (type.num_pointers == 0) throw compiler_error("Error: Expected pointer type to derefernce");
+                type.num_pointers--;
+                type.is_const = false;
+                return type;
+            default: return type;
+        }
+    }
+
+    Type type_of(BinaryOpNode* node)
+    {
+        Type lhs = check(node->lhs);
+        Type rhs = check(node->rhs);
+
+        switch (node->op)
+        {
+            case NodeKind::ADD: case NodeKind::SUB: case NodeKind::MUL: case NodeKind::DIV: case NodeKind::MOD:
+                node->convert_to = bin_op_cast(lhs, rhs);
+                if (node->convert_to.num_pointers) return lhs.num_pointers ? lhs : rhs;
+                return node->convert_to;
+            case NodeKind::EQ: case NodeKind::NOTEQ: case NodeKind::GREATER: case NodeKind::GREATEREQ: case NodeKind::LESS: case NodeKind::LESSEQ:
+                node->convert_to = bin_op_cast(lhs, rhs);
+                if (node->convert_to.num_pointers) return lhs.num_pointers ? lhs : rhs;
+                return {TypeKind::BOOL, 1};
+            // Assignment, the value is converted to the type of the variable
+            default: return lhs != rhs ? lhs : rhs;
+        }
+    }
+
+    Type type_of(TernNode* node)
+    {
+        check(node->condition);
+        Type lhs = check(node->lhs);
+        Type rhs = check(node->rhs);
+        node->convert_to = lhs == rhs ? lhs : (node->forceboolout ? Type{TypeKind::BOOL, 1} : bin_op_cast(lhs, rhs));
+        return node->convert_to;
+    }
+};
+
+void check_types(Node* node)
+{
+    TypeChecker().check(node);
+}
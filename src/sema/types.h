@@ -0,0 +1,8 @@
+#pragma once
+
+#include "node/node.h"
+
+// Works out the type of every expression and the type the operands of binary and ternary ops are converted to,
+// so codegen can emit every node once without visiting a subtree just to learn its type
+// Runs after resolve_names
+void check_types(Node* node);
@@ -1,36 +1,76 @@
 #include "symt.h"
 
-std::unordered_map<std::string, FuncEntry> function_definitions;
-std::unordered_map<std::string, GlobalEntry> global_definitions;
+#include "node/flat.h"
 
-void generate_symtables(Node* node)
-{
-    node->visit_symt();
-}
+SymbolTable<FuncEntry> function_definitions;
+SymbolTable<GlobalEntry> global_definitions;
 
-void FunctionNode::visit_symt()
+// Adds a function declaration or definition, shared by the tree and the flat AST
+static void define_function(SymbolId name, const Type& type, bool defined, ArenaList<ArgNode> args)
 {
-    if (function_definitions.contains(this->name.value) && function_definitions[this->name.value].defined)
+    if (function_definitions.contains(name) && function_definitions[name].defined)
     {
-        if (this->defined) throw compiler_error("Redefinition of function %s\n", this->name.value.c_str());
+        if (defined) throw compiler_error("Redefinition of function %s\n", symbol_name(name).data());
         else return;
     }
-    std::unordered_map<std::string, size_t> arg_to_il_name;
+    std::unordered_map<SymbolId, size_t> arg_to_il_name;
     size_t j = 0;
-    for (auto i = std::begin(this->args); i != std::end(this->args); i++, j++)
+    for (auto i = std::begin(args); i != std::end(args); i++, j++)
     {
-        if (arg_to_il_name.contains((*i).tok.value)) throw compiler_error("Redefinition of argument %s\n", (*i).tok.value.c_str());    
-        arg_to_il_name[(*i).tok.value] = j;
+        if (arg_to_il_name.contains((*i).tok.sym)) throw compiler_error("Redefinition of argument %s\n", symbol_name((*i).tok.sym).data());    
+        arg_to_il_name[(*i).tok.sym] = j;
     } 
-    function_definitions[this->name.value] = {this->type, this->name.value, this->defined, this->args, std::move(arg_to_il_name), j};
+    function_definitions[name] = {type, symbol_name(name), defined, args, std::move(arg_to_il_name), j};
 }
 
-void DeclNode::visit_symt()
+static void define_global(SymbolId name, const Type& type, bool defined)
 {
-    if (global_definitions.contains(this->name.value) && global_definitions[this->name.value].defined) 
+    if (global_definitions.contains(name) && global_definitions[name].defined) 
     {
-        if (this->defined) throw compiler_error("Redefinition of global variable %s\n", this->name.value.c_str());
+        if (defined) throw compiler_error("Redefinition of global variable %s\n", symbol_name(name).data());
         else return;
     }
-    global_definitions[this->name.value] = {this->type, this->name.value, this->defined};
+    global_definitions[name] = {type, symbol_name(name), defined};
+}
+
+void generate_symtables(Node* node)
+{
+    node->visit_symt();
+}
+
+void generate_symtables(const FlatAst& ast)
+{
+    // Only the top level is looked at, so this is a walk over the program list
+    std::vector<ArgNode> args;
+    for (uint32_t i = 0; i < ast.program.count; i++)
+    {
+        NodeRef ref = ast.item(ast.program, i);
+        if (ref.type() == NodeType::FUNCTION)
+        {
+            const FlatFunction& fn = ast.functions[ref.index()];
+            args.resize(fn.args_count);
+            for (uint32_t j = 0; j < fn.args_count; j++)
+            {
+                const FlatArg& arg = ast.args[fn.args_begin + j];
+                args[j].type = ast.type(arg.type);
+                args[j].tok = Token{TokenType::IDENT, symbol_name(arg.name), {}, arg.name};
+            }
+            define_function(fn.name, ast.type(fn.type), fn.defined, node_arena.make_list(args.data(), args.size()));
+        }
+        else if (ref.type() == NodeType::DECL)
+        {
+            const FlatDecl& decl = ast.decls[ref.index()];
+            define_global(decl.name, ast.type(decl.type), decl.defined);
+        }
+    }
+}
+
+void FunctionNode::visit_symt()
+{
+    define_function(this->name.sym, this->type, this->defined, this->args);
+}
+
+void DeclNode::visit_symt()
+{
+    define_global(this->name.sym, this->type, this->defined);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "node/node.h"
 #include "type.h"
+#include "lexer/intern.h"
 
 // std
 #include <unordered_map>
@@ -13,7 +14,7 @@
 struct GlobalEntry
 {
     Type type;
-    std::string name;
+    std::string_view name;
     bool defined;
 };
 
@@ -23,20 +24,23 @@ struct FuncEntry
     // The type of the function
     Type type;
     // The name
-    std::string name;
+    std::string_view name;
     // If this is a definition or a declaration 
     bool defined;
     // The list of args
-    std::vector<ArgNode> args;
+    ArenaList<ArgNode> args;
     // Convert an arg name to the il temporary value used
-    std::unordered_map<std::string, size_t> arg_to_il_name;
+    std::unordered_map<SymbolId, size_t> arg_to_il_name;
     // Highest value reached for temporaries + 1, where the stack/temps can start at
     size_t next_temp;
 };
 
-// Need to store definitions of functions and globals
-extern std::unordered_map<std::string, FuncEntry> function_definitions;
-extern std::unordered_map<std::string, GlobalEntry> global_definitions;
+// Need to store definitions of functions and globals, by the symbol of their name
+extern SymbolTable<FuncEntry> function_definitions;
+extern SymbolTable<GlobalEntry> global_definitions;
+
+struct FlatAst;
 
 // Generate the symtables
 void generate_symtables(Node* node);
+void generate_symtables(const FlatAst& ast);
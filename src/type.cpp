@@ -1,44 +1,40 @@
 #include "type.h"
 
+#include "util.h"
+
 
 // std
+#include <algorithm>
 #include <array>
-#include <unordered_map>
-#include <unordered_set>
-#include <sstream>
-
-std::unordered_map<Type, std::string> type_to_il_str({
-    {{TypeKind::INT, 8}, "i64"},
-    {{TypeKind::INT, 4}, "i32"},
-    {{TypeKind::INT, 2}, "i16"},
-    {{TypeKind::INT, 1}, "i8"},
-    {{TypeKind::UNSIGNED, 8}, "i64"},
-    {{TypeKind::UNSIGNED, 4}, "i32"},
-    {{TypeKind::UNSIGNED, 2}, "i16"},
-    {{TypeKind::UNSIGNED, 1}, "i8"},
-    {{TypeKind::BOOL, 1}, "i1"},
-    {{TypeKind::FLOAT, 4}, "float"},
-    {{TypeKind::FLOAT, 8}, "double"},
-    {{TypeKind::NULLTP, 0}, "null"}
-});
+#include <bit>
+#include <charconv>
+#include <cmath>
 
 // Generates a type based on constants (such as integers, floating points, arrays, and string literals)
-Type gen_const_type(Tokenizer& tokens)
+Type gen_const_type(Tokenizer& tokens, LiteralValue& value)
 {
+    std::string_view str = tokens.cur().value;
     switch (tokens.cur().type)
     {
         case TokenType::INTV:
         {
-            auto val = std::stol(tokens.cur().value);
-            if ((char) val == val) return {TypeKind::INT, 1};
-            else if ((short) val == val) return {TypeKind::INT, 2};
-            else if ((int) val == val) return {TypeKind::INT, 4};
+            auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value.i);
+            if (ec != std::errc() || end != str.data() + str.size()) throw compiler_error("Integer literal %s is out of range", std::string(str).c_str());
+            value.kind = LiteralValue::INT;
+
+            int64_t val = value.i;
+            if ((int8_t) val == val) return {TypeKind::INT, 1};
+            else if ((int16_t) val == val) return {TypeKind::INT, 2};
+            else if ((int32_t) val == val) return {TypeKind::INT, 4};
             else return {TypeKind::INT, 8};
         }
         case TokenType::FLOATV:
         {
-            auto val = std::stod(tokens.cur().value);
-            if ((float) val == val) return {TypeKind::FLOAT, 4};
+            auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value.f);
+            if (ec != std::errc() || end != str.data() + str.size()) throw compiler_error("Float literal %s is out of range", std::string(str).c_str());
+            value.kind = LiteralValue::FLOAT;
+
+            if ((float) value.f == value.f) return {TypeKind::FLOAT, 4};
             else return {TypeKind::FLOAT, 8};
         }
         default:
@@ -48,95 +44,208 @@ Type gen_const_type(Tokenizer& tokens)
     }
 }
 
-// Generates an explicit type (ie from a variable declaration or a cast)
-Type gen_expl_type(Tokenizer& tokens, Type type)
+// Types of the type specifier keywords, NULLTP for every other token
+constexpr std::array<Type, TOKEN_TYPES> make_keyword_types()
 {
-    std::unordered_map<TokenType, Type> type_map({
-        {TokenType::TLONG, {TypeKind::INT, 8}},
-        {TokenType::TINT, {TypeKind::INT, 4}},
-        {TokenType::TSHORT, {TypeKind::INT, 2}},
-        {TokenType::TCHAR, {TypeKind::INT, 1}},
-        {TokenType::TFLOAT, {TypeKind::FLOAT, 4}},
-        {TokenType::TDOUBLE, {TypeKind::FLOAT, 8}},
-    });
-
-    std::unordered_set<Type> type_set({
-        {TypeKind::INT, 8},
-        {TypeKind::INT, 4},
-        {TypeKind::INT, 2},
-        {TypeKind::INT, 1},
-        {TypeKind::FLOAT, 4},
-        {TypeKind::FLOAT, 8},
-    });
-
-    if (type_map.contains(tokens.cur().type))
+    std::array<Type, TOKEN_TYPES> table{};
+    table.fill({TypeKind::NULLTP, 0});
+
+    table[(size_t) TokenType::TLONG] = {TypeKind::INT, 8};
+    table[(size_t) TokenType::TINT] = {TypeKind::INT, 4};
+    table[(size_t) TokenType::TSHORT] = {TypeKind::INT, 2};
+    table[(size_t) TokenType::TCHAR] = {TypeKind::INT, 1};
+    table[(size_t) TokenType::TFLOAT] = {TypeKind::FLOAT, 4};
+    table[(size_t) TokenType::TDOUBLE] = {TypeKind::FLOAT, 8};
+
+    return table;
+}
+
+constexpr std::array<Type, TOKEN_TYPES> keyword_types = make_keyword_types();
+
+// A base type keyword can't follow one of these
+constexpr std::array<Type, 6> base_types{{
+    {TypeKind::INT, 8},
+    {TypeKind::INT, 4},
+    {TypeKind::INT, 2},
+    {TypeKind::INT, 1},
+    {TypeKind::FLOAT, 4},
+    {TypeKind::FLOAT, 8},
+}};
+
+TypeSpec peek_type(Tokenizer& tokens)
+{
+    TypeSpec spec;
+    Type& type = spec.type;
+
+    for (size_t& i = spec.length; ; i++)
     {
-        if (type_set.contains(type)) throw compiler_error("Invalid type for %s", type_to_il_str[type].c_str());
-        
-        tokens.inc();
-        
-        if (type.t_kind == TypeKind::UNSIGNED && type_map[tokens.prev().type].t_kind == TypeKind::INT) 
+        TokenType tok = tokens.cur(i).type;
+        const Type& keyword = keyword_types[(size_t) tok];
+
+        if (keyword)
         {
-            type.t_kind = TypeKind::UNSIGNED;
-            type.size = type_map[tokens.prev().type].size;
-            return gen_expl_type(tokens, type); 
+            if (std::find(base_types.begin(), base_types.end(), type) != base_types.end()) { spec.error = TypeSpec::INVALID; break; }
+
+            if (type.t_kind == TypeKind::UNSIGNED && keyword.t_kind == TypeKind::INT) type.size = keyword.size;
+            else if (type.t_kind == TypeKind::UNSIGNED) { spec.error = TypeSpec::INVALID_UNSIGNED; break; }
+            else
+            {
+                type.t_kind = keyword.t_kind;
+                type.size = keyword.size;
+            }
         }
-        else if (type.t_kind == TypeKind::UNSIGNED) throw compiler_error("Invalid type for unsigned %s", type_to_il_str[type].c_str());
-        else
+        else if (tok == TokenType::UNSIGNED)
         {
-            type.t_kind = type_map[tokens.prev().type].t_kind;
-            type.size = type_map[tokens.prev().type].size;
-            return gen_expl_type(tokens, type);
-        } 
+            if (type != Type{TypeKind::NULLTP, 0}) { spec.error = TypeSpec::REDECLARED; break; }
+            type = {TypeKind::UNSIGNED, 0};
+        }
+        else if (tok == TokenType::MUL && type != Type{TypeKind::NULLTP, 0})
+        {
+            if (type.num_pointers == MAX_POINTERS) { spec.error = TypeSpec::POINTERS; break; }
+            type.num_pointers++;
+        }
+        else if (tok == TokenType::CONST)
+        {
+            if (type.size_of() || type.is_const) { spec.error = TypeSpec::REDECLARED; break; }
+            type.is_const = true;
+        }
+        else break;
     }
-    else if (tokens.cur().type == TokenType::UNSIGNED)
+
+    return spec;
+}
+
+Type take_type(Tokenizer& tokens, const TypeSpec& spec)
+{
+    Type type = spec.type;
+    switch (spec.error)
     {
-        tokens.inc();
-        if (type != Type{TypeKind::NULLTP, 0}) throw compiler_error("Type %s has already been declared", type_to_il_str[type].c_str());
-        else return gen_expl_type(tokens, {TypeKind::UNSIGNED, 0});
+        case TypeSpec::INVALID: throw compiler_error("Invalid type for %s", type_to_string(type).data());
+        case TypeSpec::INVALID_UNSIGNED: throw compiler_error("Invalid type for unsigned %s", type_to_string(type).data());
+        case TypeSpec::REDECLARED: throw compiler_error("Type %s has already been declared", type_to_string(type).data());
+        case TypeSpec::POINTERS: throw compiler_error("Too many levels of pointers, at most %zu are allowed", MAX_POINTERS);
+        case TypeSpec::NONE: break;
     }
-    else if (tokens.cur().type == TokenType::MUL && type != Type{TypeKind::NULLTP, 0})
+
+    tokens.setPos(tokens.getPos() + spec.length);
+    return type;
+}
+
+// Generates an explicit type (ie from a variable declaration or a cast)
+Type gen_expl_type(Tokenizer& tokens)
+{
+    return take_type(tokens, peek_type(tokens));
+}
+
+// Does a cast for a binary operation
+Type bin_op_cast(const Type& t1, const Type& t2)
+{
+    // If both types are pointers, or either type is a pointer and the other is a float
+    if ((t1.num_pointers && t2.num_pointers) || (t1.num_pointers && t2.t_kind == TypeKind::FLOAT) || (t2.num_pointers && t1.t_kind == TypeKind::FLOAT)) throw compiler_error("Invalid operands for binary expression: '%s' and '%s'", type_to_string(t1).data(), type_to_string(t2).data());
+    if (t1.num_pointers) return t1;
+    if (t2.num_pointers) return t2;
+    if (t1.t_kind == TypeKind::FLOAT || t2.t_kind == TypeKind::FLOAT)
     {
-        tokens.inc();
-        type.num_pointers++;
-        return gen_expl_type(tokens, type);
+        uint8_t size = std::max(t1.t_kind == TypeKind::FLOAT ? t1.size : 0, t2.t_kind == TypeKind::FLOAT ? t2.size : 0);
+        return {TypeKind::FLOAT, size};
     }
-    else if (tokens.cur().type == TokenType::CONST)
+
+    // Anything narrower than an int is promoted to int first
+    Type a = t1.size < 4 ? Type{TypeKind::INT, 4} : Type{t1.t_kind, t1.size};
+    Type b = t2.size < 4 ? Type{TypeKind::INT, 4} : Type{t2.t_kind, t2.size};
+    if (a.t_kind == b.t_kind) return a.size >= b.size ? a : b;
+
+    // Mixed signedness is unsigned, unless the signed type is wider and holds every value of the unsigned one
+    const Type& u = a.t_kind == TypeKind::UNSIGNED ? a : b;
+    const Type& i = a.t_kind == TypeKind::UNSIGNED ? b : a;
+    return i.size > u.size ? i : u;
+}
+
+LiteralValue normalize_literal(Type type, LiteralValue value)
+{
+    LiteralValue out;
+    if (type.t_kind == TypeKind::FLOAT && !type.num_pointers)
     {
-        tokens.inc();
-        if (type.size_of() || type.is_const) throw compiler_error("Type %s has already been declared", type_to_il_str[type].c_str());
-        type.is_const = true;
-        return gen_expl_type(tokens, type);
+        out.kind = LiteralValue::FLOAT;
+        out.f = type.size == 4 ? (double) (float) value.as_double() : value.as_double();
+        return out;
     }
 
-    else return type;
+    out.kind = LiteralValue::INT;
+    int64_t i = value.as_int();
+    if (type.num_pointers) out.i = i;
+    else if (type.t_kind == TypeKind::BOOL) out.i = i & 1;
+    else if (type.size < 8)
+    {
+        int shift = 64 - type.size * 8;
+        out.i = type.t_kind == TypeKind::UNSIGNED ? (int64_t) ((uint64_t) i << shift >> shift) : (i << shift) >> shift;
+    }
+    else out.i = i;
+    return out;
 }
 
-// Does a cast for a binary operation
-Type bin_op_cast(const Type& t1, const Type& t2)
+LiteralValue convert_literal(LiteralValue value, Type from, Type to)
 {
-    // If both types are pointers, or either type is a pointer and the other is a float
-    if ((t1.num_pointers && t2.num_pointers) || (t1.num_pointers && t2.t_kind == TypeKind::FLOAT) || (t2.num_pointers && t1.t_kind == TypeKind::FLOAT)) throw compiler_error("Invalid operands for binary expression: '%s' and '%s'", type_to_string(t1).c_str(), type_to_string(t2).c_str());
-    if (t1 == t2) return t1;
-    
-    if (t1.t_kind == TypeKind::FLOAT || t2.t_kind == TypeKind::FLOAT) { return {TypeKind::FLOAT, (t1.size_of() > t2.size_of()) ? t1.size_of() : t2.size_of()};}
-    else if (t1.num_pointers) return t1;
-    else if (t2.num_pointers) return t2;
-    else { return {TypeKind::INT, (t1.size_of() > t2.size_of()) ? t1.size_of() : t2.size_of()};}
+    if (from.num_pointers || to.num_pointers || !from || !to) return {};
+    value = normalize_literal(from, value);
+
+    LiteralValue out;
+    if (to.t_kind == TypeKind::BOOL)
+    {
+        // Compared against zero, a NaN is true
+        out.kind = LiteralValue::INT;
+        out.i = from.t_kind == TypeKind::FLOAT ? value.f != 0 : value.i != 0;
+        return out;
+    }
+
+    if (from.t_kind == TypeKind::FLOAT && to.t_kind != TypeKind::FLOAT)
+    {
+        // fptosi and fptoui give poison for values that don't fit once truncated
+        double t = std::trunc(value.f);
+        double limit = std::ldexp(1.0, to.size * 8 - (to.t_kind == TypeKind::UNSIGNED ? 0 : 1));
+        double low = to.t_kind == TypeKind::UNSIGNED ? 0 : -limit;
+        if (!(t >= low && t < limit)) return {};
+        out.kind = LiteralValue::INT;
+        out.i = to.t_kind == TypeKind::UNSIGNED ? (int64_t) (uint64_t) t : (int64_t) t;
+        return normalize_literal(to, out);
+    }
+
+    if (to.t_kind == TypeKind::FLOAT && from.t_kind != TypeKind::FLOAT)
+    {
+        // Rounded once, straight to the size of the float
+        out.kind = LiteralValue::FLOAT;
+        if (from.t_kind == TypeKind::UNSIGNED) out.f = to.size == 4 ? (double) (float) (uint64_t) value.i : (double) (uint64_t) value.i;
+        else out.f = to.size == 4 ? (double) (float) value.i : (double) value.i;
+        return out;
+    }
+
+    // Integers are already sign or zero extended by the type they come from, so this truncates or extends them
+    return normalize_literal(to, value);
 }
 
-// Converts a stringfloat to a hexadecimal string
-std::string strfloat_to_hexfloat(const std::string& str, Type type)
+// Converts a float to its bits in hexadecimal, a float is a double with the low bits of the mantissa cleared
+std::string float_to_hexfloat(double value, Type type)
 {
-    double value = std::stod(str);
-    if (type.size_of() == 4) *(size_t*)&value &= 0xFFFFFFFFE0000000;
-    std::stringstream ss;
-    ss << "0x" << std::hex << *(size_t*)&value;
-    return ss.str();
+    uint64_t bits = std::bit_cast<uint64_t>(value);
+    if (type.size_of() == 4) bits &= 0xFFFFFFFFE0000000;
+    return "0x" + to_chars_string(bits, 16);
 }
 
-// Converts a type to a string
-std::string type_to_string(const Type& type)
+std::string literal_to_string(const LiteralValue& value, Type type)
 {
-    return type.num_pointers ? "ptr" : type_to_il_str[type];
+    if (type.t_kind == TypeKind::FLOAT)
+    {
+        // Like llvm, floats are spelled in decimal when six digits after the point give back the exact value
+        double d = value.as_double();
+        if (std::isfinite(d))
+        {
+            char buf[32];
+            char* end = std::to_chars(buf, buf + sizeof(buf), d, std::chars_format::scientific, 6).ptr;
+            double back = 0;
+            std::from_chars(buf, end, back);
+            if (std::bit_cast<uint64_t>(back) == std::bit_cast<uint64_t>(d)) return std::string(buf, end);
+        }
+        return float_to_hexfloat(d, type);
+    }
+    return to_chars_string(value.as_int());
 }
@@ -3,13 +3,15 @@
 #include "lexer/token.h"
 
 // std
-#include <unordered_map>
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 // All of the functions for typing in the compiler
 
 // The different kinds of types (such as ints, floats, and bools)
-enum class TypeKind
+enum class TypeKind : uint8_t
 {
     INT,
     UNSIGNED,
@@ -19,11 +21,13 @@ enum class TypeKind
 }; 
 
 // The actual type entry in the node or symtable entry 
+// Packed into 4 bytes, so it is passed and compared as cheaply as a type id would be and every node carrying one
+// stays small
 struct Type
 {
     TypeKind t_kind;
-    size_t size;
-    size_t num_pointers = 0;
+    uint8_t size;
+    uint8_t num_pointers = 0;
     bool is_const = false;
 
     bool operator==(const Type& type) const { return this->t_kind == type.t_kind && this->size == type.size && this->num_pointers == type.num_pointers; }
@@ -32,47 +36,79 @@ struct Type
     size_t size_of() const { return num_pointers ? 8 : size; }
 };
 
-struct TwoType
-{
-    Type lhs;
-    Type rhs;
+static_assert(sizeof(Type) == 4, "Type should pack into 4 bytes");
 
-    bool operator==(const TwoType& type) const { return this->lhs == type.lhs && this->rhs == type.rhs; }
-};
+// Deepest pointer type a declaration can have
+constexpr size_t MAX_POINTERS = UINT8_MAX;
 
-template <class T>
-inline size_t hash_combine(size_t seed, const T& v)
+// IR spelling of the non pointer types by kind and size, empty for sizes a kind doesn't have
+constexpr std::array<std::array<std::string_view, 9>, 5> il_type_names{{
+    {"", "i8", "i16", "", "i32", "", "", "", "i64"},
+    {"", "i8", "i16", "", "i32", "", "", "", "i64"},
+    {"", "", "", "", "float", "", "", "", "double"},
+    {"", "i1", "", "", "", "", "", "", ""},
+    {"null", "", "", "", "", "", "", "", ""},
+}};
+
+// Converts a type to its IR spelling, the view is null terminated so it can go straight into error messages
+constexpr std::string_view type_to_string(const Type& type)
 {
-    std::hash<T> hasher;
-    return seed ^ hasher(v) + 0x9e3779b9 + (seed<<6) + (seed>>2);
+    if (type.num_pointers) return "ptr";
+    return type.size < il_type_names[0].size() ? il_type_names[(size_t) type.t_kind][type.size] : "";
 }
 
-// Hashing stuff
-namespace std {
-    template<>
-    struct hash<Type> {
-        inline size_t operator()(const Type& type) const {
-            std::hash<TypeKind> hasher;
-            return hash_combine(hash_combine(hasher(type.t_kind), type.size_of()), type.num_pointers);
-        }
-    };
+// The value of a numeric literal, parsed once when the literal is
+struct LiteralValue
+{
+    enum Kind : uint8_t { NONE, INT, FLOAT };
 
-    template<>
-    struct hash<TwoType> {
-        inline size_t operator()(const TwoType& type) const {
-            std::hash<Type> hasher;
-            return hash_combine(hasher(type.lhs), type.rhs);
-        }
+    Kind kind = NONE;
+    union
+    {
+        int64_t i = 0;
+        double f;
     };
-}
 
-// Generates a type from a literal
-Type gen_const_type(Tokenizer& tokens);
-// Generates the result type from 2 types
+    explicit operator bool() const { return kind != NONE; }
+    // The value converted the way a C cast would
+    int64_t as_int() const { return kind == FLOAT ? (int64_t) f : i; }
+    double as_double() const { return kind == FLOAT ? f : (double) i; }
+};
+
+// Generates a type from a literal and parses its value
+Type gen_const_type(Tokenizer& tokens, LiteralValue& value);
+// The form a value has in type: floats rounded to their size, integers truncated and sign or zero extended back
+LiteralValue normalize_literal(Type type, LiteralValue value);
+// A constant of type from converted to type to the way cast instructions convert it, none if the conversion has no
+// defined result (a float out of range of an integer type) or a type is a pointer
+LiteralValue convert_literal(LiteralValue value, Type from, Type to);
+// Generates the result type from 2 types, with C's integer promotions and usual arithmetic conversions
 Type bin_op_cast(const Type& lhs, const Type& rhs);
+// A type specifier scanned ahead of the parser, the tokens aren't consumed and nothing is thrown
+// So the parser can check for a type and reuse what it found instead of parsing it again
+struct TypeSpec
+{
+    enum Error { NONE, INVALID, INVALID_UNSIGNED, REDECLARED, POINTERS };
+
+    // NULLTP if the tokens don't start a type, on an error it's the type parsed up to the error
+    Type type = {TypeKind::NULLTP, 0};
+    // Number of tokens in the specifier
+    size_t length = 0;
+    Error error = NONE;
+
+    // If the tokens are a valid type
+    bool is_type() const { return !error && type; }
+    // If the tokens start a type, which may still be invalid
+    bool starts_type() const { return error || type; }
+};
+
+// Scans the type specifier starting at the current token
+TypeSpec peek_type(Tokenizer& tokens);
+// Consumes the tokens of a scanned type specifier, throws if it isn't valid
+Type take_type(Tokenizer& tokens, const TypeSpec& spec);
 // Generates a type from a explicit type token like float
-Type gen_expl_type(Tokenizer& tokens, Type type);
-// Converts a string float to a hexadecimal floats
-std::string strfloat_to_hexfloat(const std::string& str, Type type);
-// Converts a type to a string 
-std::string type_to_string(const Type& type);
+Type gen_expl_type(Tokenizer& tokens);
+// Converts a float to the hexadecimal form the IR uses for a float of type
+std::string float_to_hexfloat(double value, Type type);
+// Prints a literal value as an IR constant of type
+std::string literal_to_string(const LiteralValue& value, Type type);
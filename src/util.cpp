@@ -5,6 +5,11 @@
 #include <string>
 #include <stdexcept>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 // Remove a character (arg 1) from the string (arg 2)
 // However, it will not remove characters surrounded by '
 std::string remove_char(char character, const std::string& data)
@@ -54,6 +59,42 @@ std::string read_file(const std::string& filepath)
     return str;
 }
 
+MappedFile::MappedFile(const std::string& filepath)
+{
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot find file");
+
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        close(fd);
+        throw std::runtime_error("Cannot read file");
+    }
+
+    // mmap can't map an empty file, so just leave it as an empty view
+    len = st.st_size;
+    if (len)
+    {
+        void* map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("Cannot map file");
+        }
+
+        // The file is read front to back once by the lexer
+        madvise(map, len, MADV_SEQUENTIAL);
+        ptr = (const char*) map;
+    }
+
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (ptr) munmap((void*) ptr, len);
+}
+
 void write_file(const std::string& filepath, const std::string& data)
 {
     std::ofstream file(filepath, std::ios::trunc);
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <charconv>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <iostream>
 
@@ -10,27 +12,31 @@ std::string remove_char(char character, const std::string& data);
 // Read data from a file into a string
 std::string read_file(const std::string& filepath);
 
+// A file mapped read only into memory, so it can be lexed without copying it
+class MappedFile
+{
+private:
+    const char* ptr = nullptr;
+    size_t len = 0;
+public:
+    MappedFile(const std::string& filepath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view data() const { return std::string_view(ptr, len); }
+};
+
 // Write data to a file (existing or created) from a string
 void write_file(const std::string& filepath, const std::string& data);
 
-// sprint (prints to a string, using std::stringstream, the laziest thing in the world)
-template <typename Arg>
-void sprinta(std::string* write, Arg arg)
+// Prints a number with std::to_chars, without going through a stream or the locale
+template <typename T>
+std::string to_chars_string(T value, int base = 10)
 {
-    std::stringstream str;
-    str << arg;
-    write->append(str.str());
-    return;
-}
-
-template <typename Arg, typename... Args>
-void sprinta(std::string* write, Arg arg, Args... args)
-{
-    std::stringstream str;
-    str << arg;
-    write->append(str.str());
-    sprinta(write, args...);
-    return;
+    char buf[24];
+    return std::string(buf, std::to_chars(buf, buf + sizeof(buf), value, base).ptr);
 }
 
 // oprinta (prints to std output, using std::iostream, the laziest thing in the world)
@@ -0,0 +1,178 @@
+#include "bench.h"
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "symt/symt.h"
+#include "node/flat.h"
+
+// Both walks visit every node in the order codegen does and hash what codegen would read, so they do the same work
+static uint64_t mix(uint64_t h, uint64_t v) { return (h ^ v) * 0x100000001b3ull; }
+
+static uint64_t walk(Node* node)
+{
+    if (!node) return 1;
+
+    uint64_t h = (uint64_t) node->node_type;
+    switch (node->node_type)
+    {
+        case NodeType::FUNCTION:
+        {
+            auto* fn = static_cast<FunctionNode*>(node);
+            h = mix(h, fn->name.sym);
+            for (const ArgNode& arg : fn->args) h = mix(h, arg.tok.sym);
+            for (Node* item : fn->statements.forward) h = mix(h, walk(item));
+            return h;
+        }
+        case NodeType::DECL: return mix(mix(h, static_cast<DeclNode*>(node)->name.sym), walk(static_cast<DeclNode*>(node)->assign));
+        case NodeType::BLOCKSTMT:
+            for (Node* item : static_cast<BlockStmtNode*>(node)->forward) h = mix(h, walk(item));
+            return h;
+        case NodeType::TERMCHECK: return mix(h, walk(static_cast<TerminatorCheckNode*>(node)->forward));
+        case NodeType::RETURN: return mix(h, walk(static_cast<RetNode*>(node)->value));
+        case NodeType::IF:
+        {
+            auto* inode = static_cast<IfNode*>(node);
+            return mix(mix(mix(h, walk(inode->condition)), walk(inode->statement)), walk(inode->else_stmt));
+        }
+        case NodeType::FOR:
+        {
+            auto* fnode = static_cast<ForNode*>(node);
+            return mix(mix(mix(mix(h, walk(fnode->initial)), walk(fnode->condition)), walk(fnode->statement)), walk(fnode->end));
+        }
+        case NodeType::WHILE:
+        {
+            auto* wnode = static_cast<WhileNode*>(node);
+            return mix(mix(h, walk(wnode->condition)), walk(wnode->statement));
+        }
+        case NodeType::CAST: return mix(h, walk(static_cast<CastNode*>(node)->forward));
+        case NodeType::UNARY: return mix(mix(h, (uint64_t) static_cast<UnaryOpNode*>(node)->op), walk(static_cast<UnaryOpNode*>(node)->forward));
+        case NodeType::BINARY:
+        {
+            auto* op = static_cast<BinaryOpNode*>(node);
+            return mix(mix(mix(h, (uint64_t) op->op), walk(op->lhs)), walk(op->rhs));
+        }
+        case NodeType::TERN:
+        {
+            auto* tern = static_cast<TernNode*>(node);
+            return mix(mix(mix(h, walk(tern->condition)), walk(tern->lhs)), walk(tern->rhs));
+        }
+        case NodeType::LITERAL: return mix(h, static_cast<LiteralNode*>(node)->value.i);
+        case NodeType::VAR: return mix(h, static_cast<VarNode*>(node)->name.sym);
+        case NodeType::FUNCALL:
+        {
+            auto* fn = static_cast<FuncallNode*>(node);
+            h = mix(h, fn->name.sym);
+            for (Node* arg : fn->args) h = mix(h, walk(arg));
+            return h;
+        }
+        default: return h;
+    }
+}
+
+static uint64_t walk(const FlatAst& ast, NodeRef ref)
+{
+    if (!ref) return 1;
+
+    uint64_t h = (uint64_t) ref.type();
+    switch (ref.type())
+    {
+        case NodeType::FUNCTION:
+        {
+            const FlatFunction& fn = ast.functions[ref.index()];
+            h = mix(h, fn.name);
+            for (uint32_t i = 0; i < fn.args_count; i++) h = mix(h, ast.args[fn.args_begin + i].name);
+            for (uint32_t i = 0; i < fn.body.count; i++) h = mix(h, walk(ast, ast.item(fn.body, i)));
+            return h;
+        }
+        case NodeType::DECL: return mix(mix(h, ast.decls[ref.index()].name), walk(ast, ast.decls[ref.index()].assign));
+        case NodeType::BLOCKSTMT:
+        {
+            ExtraRange items = ast.blocks[ref.index()].items;
+            for (uint32_t i = 0; i < items.count; i++) h = mix(h, walk(ast, ast.item(items, i)));
+            return h;
+        }
+        case NodeType::TERMCHECK: return mix(h, walk(ast, ast.termchecks[ref.index()].forward));
+        case NodeType::RETURN: return mix(h, walk(ast, ast.rets[ref.index()].value));
+        case NodeType::IF:
+        {
+            const FlatIf& inode = ast.ifs[ref.index()];
+            return mix(mix(mix(h, walk(ast, inode.condition)), walk(ast, inode.statement)), walk(ast, inode.else_stmt));
+        }
+        case NodeType::FOR:
+        {
+            const FlatFor& fnode = ast.fors[ref.index()];
+            return mix(mix(mix(mix(h, walk(ast, fnode.initial)), walk(ast, fnode.condition)), walk(ast, fnode.statement)), walk(ast, fnode.end));
+        }
+        case NodeType::WHILE:
+        {
+            const FlatWhile& wnode = ast.whiles[ref.index()];
+            return mix(mix(h, walk(ast, wnode.condition)), walk(ast, wnode.statement));
+        }
+        case NodeType::CAST: return mix(h, walk(ast, ast.casts[ref.index()].forward));
+        case NodeType::UNARY: return mix(mix(h, (uint64_t) ast.unaries[ref.index()].op), walk(ast, ast.unaries[ref.index()].forward));
+        case NodeType::BINARY:
+        {
+            const FlatBinary& op = ast.binaries[ref.index()];
+            return mix(mix(mix(h, (uint64_t) op.op), walk(ast, op.lhs)), walk(ast, op.rhs));
+        }
+        case NodeType::TERN:
+        {
+            const FlatTern& tern = ast.terns[ref.index()];
+            return mix(mix(mix(h, walk(ast, tern.condition)), walk(ast, tern.lhs)), walk(ast, tern.rhs));
+        }
+        case NodeType::LITERAL: return mix(h, ast.literals[ref.index()].value.i);
+        case NodeType::VAR: return mix(h, ast.vars[ref.index()].name);
+        case NodeType::FUNCALL:
+        {
+            const FlatFuncall& fn = ast.funcalls[ref.index()];
+            h = mix(h, fn.name);
+            for (uint32_t i = 0; i < fn.args.count; i++) h = mix(h, walk(ast, ast.item(fn.args, i)));
+            return h;
+        }
+        default: return h;
+    }
+}
+
+static void bench_ast()
+{
+    for (size_t size : {1ul << 20, 16ul << 20})
+    {
+        std::string src = gen_program(size);
+        Tokenizer tokens = scan(src);
+        node_arena.release();
+        ProgramNode* program = parse_program(tokens);
+
+        FlatAst ast;
+        double flatten_ms = time_ms([&] { ast = flatten(program); });
+        size_t nodes = ast.node_count();
+
+        printf("  %6.1f MB: %zu nodes, flattened in %.2f ms\n", src.size() / 1e6, nodes, flatten_ms);
+        printf("             tree %5.1f bytes per node, flat %5.1f bytes per node\n", (double) node_arena.bytes_used() / nodes, (double) ast.bytes() / nodes);
+
+        double tree_symt = time_ms([&] { function_definitions.clear(); global_definitions.clear(); generate_symtables(program); });
+        double flat_symt = time_ms([&] { function_definitions.clear(); global_definitions.clear(); generate_symtables(ast); });
+        printf("             symtab pass: tree %7.2f ms, flat %7.2f ms\n", tree_symt, flat_symt);
+
+        uint64_t tree_hash = 0, flat_hash = 0;
+        double tree_walk = time_ms([&] {
+            tree_hash = 0;
+            for (Node* item : program->forward) tree_hash = mix(tree_hash, walk(item));
+        });
+        double flat_walk = time_ms([&] {
+            flat_hash = 0;
+            for (uint32_t i = 0; i < ast.program.count; i++) flat_hash = mix(flat_hash, walk(ast, ast.item(ast.program, i)));
+        });
+        printf("             codegen order walk: tree %7.2f ms, flat %7.2f ms%s\n", tree_walk, flat_walk, tree_hash == flat_hash ? "" : " (MISMATCH)");
+
+        // A pass that only looks at one kind of node doesn't need the tree at all with the pools
+        std::vector<uint32_t> uses(symbol_count());
+        double linear = time_ms([&] { for (const FlatVar& var : ast.vars) uses[var.name]++; });
+        printf("             linear walk counting %zu variable uses: %.3f ms\n", ast.vars.size(), linear);
+
+        function_definitions.clear();
+        global_definitions.clear();
+        node_arena.release();
+    }
+}
+
+static Benchmark ast_bench("ast", bench_ast);
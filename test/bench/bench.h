@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Small benchmark harness for the compiler stages
+// Every bench file registers its benchmarks with a static Benchmark object
+
+struct Benchmark
+{
+    const char* name;
+    void (*run)();
+
+    Benchmark(const char* name, void (*run)());
+
+    static std::vector<Benchmark*>& all();
+};
+
+// Number of heap allocations and bytes allocated so far, counted by the global operator new in main.cpp
+extern size_t alloc_count;
+extern size_t alloc_bytes;
+// Number of C++ exceptions thrown so far
+extern size_t exception_count;
+
+// Runs f reps times and returns the fastest run in milliseconds
+template <typename F>
+double time_ms(F&& f, size_t reps = 5)
+{
+    double best = 0;
+    for (size_t i = 0; i < reps; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+// Generates a valid Delta program of roughly bytes size, made up of many small functions
+std::string gen_program(size_t bytes);
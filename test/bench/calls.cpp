@@ -0,0 +1,43 @@
+#include "bench.h"
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "compile.h"
+#include "symt/symt.h"
+#include "codegen/codegen.h"
+
+// Functions that are mostly calls with a few arguments each, so the time goes into binding call sites and variables
+static std::string gen_calls(size_t functions, size_t calls)
+{
+    std::string src = "int g(int a, int b, int c, int d)\n{\n    return a + b;\n}\n\n";
+    for (size_t f = 0; f < functions; f++)
+    {
+        src += "int f" + std::to_string(f) + "(int x, int y)\n{\n";
+        for (size_t c = 0; c < calls; c++) src += "    x = g(x, y, x, y);\n";
+        src += "    return x;\n}\n\n";
+    }
+    return src;
+}
+
+static void bench_calls()
+{
+    for (size_t calls : {1000, 4000})
+    {
+        std::string src = gen_calls(4, calls);
+        reset_compiler();
+
+        auto tokens = scan(src);
+        Node* node = parse_program(tokens);
+
+        // The symtables are built again every run, from the same nodes
+        double sema_ms = time_ms([&] { function_definitions.clear(); global_definitions.clear(); run_passes(node); }, 3);
+        size_t allocs = alloc_count;
+        double codegen_ms = time_ms([&] { codegen(node); }, 3);
+        allocs = (alloc_count - allocs) / 3;
+        printf("  %5zu calls per function: sema %6.2f ms, codegen %8.2f ms, %.1f allocations per call in codegen\n", calls, sema_ms, codegen_ms, (double) allocs / (4 * calls));
+    }
+
+    reset_compiler();
+}
+
+static Benchmark calls("calls", bench_calls);
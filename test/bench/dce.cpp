@@ -0,0 +1,91 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "compile.h"
+#include "codegen/codegen.h"
+#include "ir/passes.h"
+#include "util.h"
+#include "error/error.h"
+
+// Instruction counts of the test corpus once its locals are promoted, before and after dead code elimination
+// Run from the root of the repo, it is skipped if the corpus isn't there
+
+static size_t count_insts(const Module& ir)
+{
+    size_t insts = 0;
+    for (const Function& fn : ir.functions)
+    {
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next) insts++;
+        }
+    }
+    return insts;
+}
+
+static void bench_dce()
+{
+    std::filesystem::path corpus = "test/tests/test";
+    if (!std::filesystem::exists(corpus))
+    {
+        printf("  skipped, %s isn't there\n", corpus.string().c_str());
+        return;
+    }
+
+    struct Counts { std::string name; size_t before; size_t after; };
+    std::vector<Counts> counts;
+    size_t total_before = 0;
+    size_t total_after = 0;
+    double dce_ms = 0;
+
+    for (const auto& entry : std::filesystem::directory_iterator(corpus))
+    {
+        if (entry.path().extension() != ".c") continue;
+        reset_compiler();
+
+        try
+        {
+            auto tokens = scan(read_file(entry.path().string()));
+            Node* node = parse_program(tokens);
+            run_passes(node);
+
+            Module ir = generate_ir(node);
+            for (Function& fn : ir.functions)
+            {
+                if (fn.defined) promote_allocas(ir, fn);
+            }
+            size_t before = count_insts(ir);
+            dce_ms += time_ms([&] {
+                for (Function& fn : ir.functions)
+                {
+                    if (fn.defined) eliminate_dead_code(ir, fn);
+                }
+            }, 1);
+            size_t after = count_insts(ir);
+
+            counts.push_back({entry.path().stem().string(), before, after});
+            total_before += before;
+            total_after += after;
+        }
+        catch (compiler_error&)
+        {
+            // Tests of programs dcc has to reject
+        }
+    }
+
+    std::sort(counts.begin(), counts.end(), [](const Counts& a, const Counts& b) { return a.before - a.after > b.before - b.after; });
+    for (size_t i = 0; i < counts.size() && i < 5; i++)
+    {
+        printf("  %-28s %5zu -> %5zu instructions\n", counts[i].name.c_str(), counts[i].before, counts[i].after);
+    }
+    printf("  %zu programs: %zu -> %zu instructions (%.1f%% removed), elimination took %.3f ms\n", counts.size(), total_before, total_after,
+        100.0 * (total_before - total_after) / total_before, dce_ms);
+
+    reset_compiler();
+}
+
+static Benchmark dce("dce", bench_dce);
\ No newline at end of file
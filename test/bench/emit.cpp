@@ -0,0 +1,49 @@
+#include "bench.h"
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "compile.h"
+#include "codegen/codegen.h"
+
+// Loops nested inside loops and ifs, with breaks and continues, so every level adds blocks and branches to the IR text
+static std::string gen_nested_loops(size_t functions, size_t depth)
+{
+    std::string src;
+    for (size_t f = 0; f < functions; f++)
+    {
+        src += "int f" + std::to_string(f) + "(int x)\n{\n    int s = 0;\n";
+        for (size_t d = 0; d < depth; d++)
+        {
+            std::string i = "i" + std::to_string(d);
+            src += "    for (int " + i + " = 0; " + i + " < x; " + i + "++)\n    {\n";
+            src += "        if (" + i + " == 3) continue;\n";
+            src += "        s = s + " + i + " * 2;\n";
+            src += "        while (s > 1000) { s = s - 7; if (s < 5) break; }\n";
+            src += "        if (s > 100000) break;\n";
+        }
+        for (size_t d = 0; d < depth; d++) src += "    }\n";
+        src += "    return s;\n}\n\n";
+    }
+    return src;
+}
+
+static void bench_emit()
+{
+    for (size_t depth : {8, 32, 128})
+    {
+        std::string src = gen_nested_loops(64, depth);
+        reset_compiler();
+
+        auto tokens = scan(src);
+        Node* node = parse_program(tokens);
+        run_passes(node);
+
+        size_t bytes = codegen(node).size();
+        double ms = time_ms([&] { codegen(node); }, 3);
+        printf("  depth %3zu: codegen %8.2f ms, %6.1f MB of IR, %6.2f ns per byte of IR\n", depth, ms, bytes / 1e6, ms * 1e6 / bytes);
+    }
+
+    reset_compiler();
+}
+
+static Benchmark emit("emit", bench_emit);
@@ -0,0 +1,58 @@
+#include "bench.h"
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "compile.h"
+#include "codegen/codegen.h"
+#include "ir/print.h"
+
+// Functions made of long expressions over variables, literals, casts and ternaries, so codegen is mostly passing operands around
+static std::string gen_exprs(size_t functions, size_t statements)
+{
+    std::string src;
+    for (size_t f = 0; f < functions; f++)
+    {
+        src += "int f" + std::to_string(f) + "(int a, int b, long c)\n{\n    int x = 0;\n    double d = 1.5;\n";
+        for (size_t s = 0; s < statements; s++)
+        {
+            std::string n = std::to_string(s);
+            src += "    x = (a + b * " + n + ") / (c - 1) + (a < b ? a : b) - -x;\n";
+            src += "    d = d * (x + " + n + ".5) - (a == " + n + " ? d : c);\n";
+            src += "    c = ~(long) x + !b + (c > " + n + ") * d;\n";
+        }
+        src += "    return x;\n}\n\n";
+    }
+    return src;
+}
+
+static void bench_exprs()
+{
+    for (size_t statements : {1000, 8000})
+    {
+        std::string src = gen_exprs(4, statements);
+        reset_compiler();
+
+        auto tokens = scan(src);
+        Node* node = parse_program(tokens);
+        run_passes(node);
+
+        Module ir = generate_ir(node);
+        size_t insts = 0;
+        for (const Function& fn : ir.functions) insts += fn.insts.size();
+
+        size_t allocs = alloc_count;
+        double build_ms = time_ms([&] { generate_ir(node); }, 3);
+        double build_allocs = (double) (alloc_count - allocs) / 3 / insts;
+
+        allocs = alloc_count;
+        double print_ms = time_ms([&] { print_ir(ir); }, 3);
+        double print_allocs = (double) (alloc_count - allocs) / 3 / insts;
+
+        printf("  %7zu instructions: build %7.2f ms (%.3f allocations per instruction), print %7.2f ms (%.3f allocations per instruction)\n",
+            insts, build_ms, build_allocs, print_ms, print_allocs);
+    }
+
+    reset_compiler();
+}
+
+static Benchmark exprs("exprs", bench_exprs);
\ No newline at end of file
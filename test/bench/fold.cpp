@@ -0,0 +1,68 @@
+#include "bench.h"
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "compile.h"
+#include "sema/fold.h"
+#include "codegen/codegen.h"
+#include "ir/passes.h"
+
+// Functions whose statements mix a variable with expressions made only of literals, casts and const locals,
+// like sizes and limits written out as arithmetic
+static std::string gen_constants(size_t functions, size_t statements)
+{
+    std::string src;
+    for (size_t f = 0; f < functions; f++)
+    {
+        src += "long f" + std::to_string(f) + "(long x)\n{\n    const int scale = 1000;\n    const double rate = 0.25;\n";
+        for (size_t s = 0; s < statements; s++)
+        {
+            std::string n = std::to_string(s);
+            src += "    x = x + 60 * 60 * 24 * " + n + " / scale - ((long) 3.5) * -" + n + ";\n";
+            src += "    x = x * (4 / 2 == 2 ? 2 : 3) + ((int) (rate * scale)) % (" + n + " + 7);\n";
+            src += "    x = x - (" + n + " > 100 && scale != 0) + ~" + n + " * !0.0;\n";
+        }
+        src += "    return x;\n}\n\n";
+    }
+    return src;
+}
+
+// Instructions left once the program is optimized, after folding it or not
+static size_t optimized_insts(const std::string& src, bool fold, double* fold_ms)
+{
+    reset_compiler();
+
+    auto tokens = scan(src);
+    Node* node = parse_program(tokens);
+    check_program(node);
+    if (fold) *fold_ms = time_ms([&] { fold_constants(node); }, 1);
+
+    Module ir = generate_ir(node);
+    optimize(ir);
+    size_t insts = 0;
+    for (const Function& fn : ir.functions)
+    {
+        for (BlockId block : fn.layout)
+        {
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next) insts++;
+        }
+    }
+    return insts;
+}
+
+static void bench_fold()
+{
+    for (size_t statements : {1000, 8000})
+    {
+        std::string src = gen_constants(4, statements);
+        double fold_ms = 0;
+        size_t before = optimized_insts(src, false, &fold_ms);
+        size_t after = optimized_insts(src, true, &fold_ms);
+        printf("  %5zu statements: %7zu instructions unfolded, %7zu folded (%.2fx fewer), folding took %6.2f ms\n",
+            statements * 12, before, after, (double) before / after, fold_ms);
+    }
+
+    reset_compiler();
+}
+
+static Benchmark fold("fold", bench_fold);
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "bench.h"
+
+#include "lexer/lexer.h"
+#include "util.h"
+
+#include <cstdio>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Runs f in a child process, so the peak RSS is only what f used
+static void measure(const char* name, size_t (*f)(const std::string&), const std::string& path)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        size_t count = 0;
+        double ms = time_ms([&] { count = f(path); }, 1);
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        printf("  %-24s %9zu tokens in %8.1f ms, peak RSS %7.1f MB\n", name, count, ms, usage.ru_maxrss / 1024.0);
+        fflush(stdout);
+        _exit(0);
+    }
+    waitpid(pid, nullptr, 0);
+}
+
+// The old path, read the whole file into a string and lex all of it before parsing
+static size_t read_and_scan(const std::string& path)
+{
+    return scan(read_file(path)).size();
+}
+
+// Map the file and pull tokens through the lookahead ring, like the parser does
+static size_t map_and_stream(const std::string& path)
+{
+    MappedFile file(path);
+    auto tokens = stream(file.data());
+
+    size_t count = 0;
+    for (; !tokens.end(); tokens.inc()) count++;
+    return count;
+}
+
+static void bench_input()
+{
+    std::string path = "/tmp/dcc_bench_input.c";
+    write_file(path, gen_program(128ul << 20));
+
+    measure("read_file + scan", read_and_scan, path);
+    measure("mmap + stream", map_and_stream, path);
+
+    remove(path.c_str());
+}
+
+static Benchmark input("input", bench_input);
@@ -0,0 +1,272 @@
+#include "bench.h"
+
+#include <cstdlib>
+#include <filesystem>
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "compile.h"
+#include "codegen/codegen.h"
+#include "ir/passes.h"
+#include "ir/print.h"
+#include "util.h"
+
+// Small loop kernels compiled by dcc, run through llc (no opt, like dcc's output is used) and timed when they run
+// Each is built without passes, with its locals promoted, and with its values numbered too, and the last two are also
+// built counting the IR instructions they run, so the passes' effect shows without the noise of timing
+// Needs llc and cc on the path, and is skipped without them
+
+static const char* kernels_src = R"(
+int k_sum(int n)
+{
+    int s = 0;
+    for (int i = 0; i < n; i++) s = s + i * i % 7;
+    return s;
+}
+
+int k_nested(int n)
+{
+    int s = 0;
+    for (int i = 0; i < n / 1000; i++)
+    {
+        for (int j = 0; j < 1000; j++) s = s + (i < j ? i : j);
+    }
+    return s;
+}
+
+int k_collatz(int n)
+{
+    int steps = 0;
+    long x = 0;
+    for (int i = 1; i < n / 100; i++)
+    {
+        x = i;
+        while (x != 1)
+        {
+            if (x % 2 == 0) x = x / 2;
+            else x = 3 * x + 1;
+            steps++;
+        }
+    }
+    return steps;
+}
+
+int k_fib(int n)
+{
+    int a = 0;
+    int b = 1;
+    int i = 0;
+    int t = 0;
+    do
+    {
+        t = (a + b) % 1000007;
+        a = b;
+        b = t;
+        i++;
+    } while (i < n);
+    return a;
+}
+
+int k_float(int n)
+{
+    double acc = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        if (i % 3 == 0) continue;
+        acc = acc * 0.999 + i;
+    }
+    return (int) acc;
+}
+
+int k_cse(int n)
+{
+    int s = 0;
+    int a = 0;
+    int b = 0;
+    for (int i = 0; i < n; i++)
+    {
+        a = i % 13;
+        b = i % 7;
+        s = (s + a * b + a * b / 3 - a * b % 5 + (a + b) * (a + b)) % 1000003;
+    }
+    return s;
+}
+
+int scale = 3;
+int bias = 1;
+
+int k_memory(int n)
+{
+    int s = 0;
+    int* p = &scale;
+    for (int i = 0; i < n; i++)
+    {
+        s = (s + scale * i + *p * bias + bias) % 1000003;
+    }
+    return s;
+}
+)";
+
+// Times every kernel, the fastest of 3 runs each, and counts the instructions one run takes if they are counted
+static const char* driver_src = R"(
+#include <stdio.h>
+#include <time.h>
+
+int k_sum(int); int k_nested(int); int k_collatz(int); int k_fib(int); int k_float(int); int k_cse(int); int k_memory(int);
+
+// Defined by the kernels when they count their instructions
+__attribute__((weak)) long dcc_insts = 0;
+
+static double now_ms(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+int main(void)
+{
+    const char* names[] = {"sum", "nested", "collatz", "fib", "float", "cse", "memory"};
+    int (*kernels[])(int) = {k_sum, k_nested, k_collatz, k_fib, k_float, k_cse, k_memory};
+    for (int k = 0; k < 7; k++)
+    {
+        double best = 0;
+        int result = 0;
+        long insts = 0;
+        for (int rep = 0; rep < 3; rep++)
+        {
+            long counted = dcc_insts;
+            double start = now_ms();
+            result = kernels[k](20000000);
+            double ms = now_ms() - start;
+            insts = dcc_insts - counted;
+            if (rep == 0 || ms < best) best = ms;
+        }
+        printf("%s %f %d %ld\n", names[k], best, result, insts);
+    }
+    return 0;
+}
+)";
+
+static bool run(const std::string& cmd)
+{
+    return std::system((cmd + " >/dev/null 2>&1").c_str()) == 0;
+}
+
+struct KernelTime
+{
+    char name[32];
+    double ms;
+    int result;
+    long insts;
+};
+
+enum class Passes { NONE, PROMOTE, NUMBER };
+
+// Adds the number of instructions in each block to the global dcc_insts every time the block runs
+static void count_executed(Module& ir)
+{
+    Type i64 = {TypeKind::INT, 8};
+    Value counter(Value::GLOBAL, ir.globals.size());
+    ir.globals.push_back({"dcc_insts", i64, ir.constant(i64, LiteralValue{})});
+    ir.order.insert(ir.order.begin(), counter);
+
+    for (Function& fn : ir.functions)
+    {
+        if (!fn.defined) continue;
+        for (BlockId block : fn.layout)
+        {
+            LiteralValue insts;
+            insts.kind = LiteralValue::INT;
+            for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next) insts.i++;
+
+            // Before the terminator, which is the block's last instruction
+            Inst load{Op::LOAD};
+            load.type = i64;
+            load.align = 8;
+            load.ops[0] = counter;
+            InstId loaded = fn.insert(block, fn.blocks[block].last, load);
+
+            Inst add{Op::ADD};
+            add.type = i64;
+            add.ops = {Value(Value::INST, loaded), ir.constant(i64, insts)};
+            InstId added = fn.insert(block, fn.blocks[block].last, add);
+
+            Inst store{Op::STORE};
+            store.type = i64;
+            store.align = 8;
+            store.ops = {Value(Value::INST, added), counter};
+            fn.insert(block, fn.blocks[block].last, store);
+        }
+    }
+}
+
+// Builds the kernels with the passes and runs them, empty if the tools aren't there
+static std::vector<KernelTime> time_kernels(Node* node, const std::filesystem::path& dir, Passes passes, bool count)
+{
+    Module ir = generate_ir(node);
+    for (Function& fn : ir.functions)
+    {
+        if (!fn.defined || passes == Passes::NONE) continue;
+        promote_allocas(ir, fn);
+        if (passes == Passes::NUMBER) number_values(ir, fn);
+        eliminate_dead_code(ir, fn);
+    }
+    if (count) count_executed(ir);
+
+    std::string name = "kernels" + std::to_string((int) passes) + (count ? "_counted" : "");
+    std::string ll = (dir / (name + ".ll")).string();
+    std::string obj = (dir / (name + ".o")).string();
+    std::string exe = (dir / name).string();
+    write_file(ll, print_ir(ir));
+    if (!run("llc -opaque-pointers -relocation-model=pic -filetype=obj -o " + obj + " " + ll)) return {};
+    if (!run("cc -O2 -o " + exe + " " + (dir / "driver.c").string() + " " + obj)) return {};
+
+    std::vector<KernelTime> times;
+    FILE* out = popen(exe.c_str(), "r");
+    if (!out) return {};
+    KernelTime time;
+    while (fscanf(out, "%31s %lf %d %ld", time.name, &time.ms, &time.result, &time.insts) == 4) times.push_back(time);
+    pclose(out);
+    return times;
+}
+
+static void bench_kernels()
+{
+    reset_compiler();
+
+    auto tokens = scan(kernels_src);
+    Node* node = parse_program(tokens);
+    run_passes(node);
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "dcc_kernels";
+    std::filesystem::create_directories(dir);
+    write_file((dir / "driver.c").string(), driver_src);
+
+    std::vector<KernelTime> allocas = time_kernels(node, dir, Passes::NONE, false);
+    std::vector<KernelTime> promoted = time_kernels(node, dir, Passes::PROMOTE, false);
+    std::vector<KernelTime> numbered = time_kernels(node, dir, Passes::NUMBER, false);
+    std::vector<KernelTime> promoted_insts = time_kernels(node, dir, Passes::PROMOTE, true);
+    std::vector<KernelTime> numbered_insts = time_kernels(node, dir, Passes::NUMBER, true);
+    size_t n = allocas.size();
+    if (!n || promoted.size() != n || numbered.size() != n || promoted_insts.size() != n || numbered_insts.size() != n)
+    {
+        printf("  skipped, llc or cc isn't available\n");
+    }
+    else
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            bool same = allocas[i].result == promoted[i].result && promoted[i].result == numbered[i].result;
+            printf("  %-8s allocas %8.2f ms, promoted %8.2f ms (%.2fx), numbered %8.2f ms (%.2fx), %11ld -> %11ld instructions run (%.1f%% fewer)%s\n",
+                allocas[i].name, allocas[i].ms, promoted[i].ms, allocas[i].ms / promoted[i].ms, numbered[i].ms, promoted[i].ms / numbered[i].ms,
+                promoted_insts[i].insts, numbered_insts[i].insts, 100.0 * (promoted_insts[i].insts - numbered_insts[i].insts) / promoted_insts[i].insts,
+                same ? "" : ", RESULTS DIFFER");
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+    reset_compiler();
+}
+
+static Benchmark kernels("kernels", bench_kernels);
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "bench.h"
+
+#include "lexer/lexer.h"
+#include "lexer/simd.h"
+
+static const char* level_names[] = {"scalar", "sse2", "avx2"};
+
+static void bench_lexer()
+{
+    for (size_t size : {1ul << 20, 16ul << 20})
+    {
+        std::string src = gen_program(size);
+        size_t count = 0;
+        double ms = time_ms([&] { count = scan(src).size(); });
+
+        size_t allocs = alloc_count, bytes = alloc_bytes;
+        scan(src);
+        allocs = alloc_count - allocs;
+        bytes = alloc_bytes - bytes - src.size();
+
+        printf("  %6.1f MB: %9zu tokens in %8.2f ms, %6.1f Mtokens/s, %6.1f MB/s\n", src.size() / 1e6, count, ms, count / ms / 1e3, src.size() / ms / 1e3);
+        printf("             %zu allocations, %.1f bytes allocated per token\n", allocs, (double) bytes / count);
+    }
+}
+
+// Throughput of the scanners on their own (long runs) and of the lexer with each of them
+static void bench_scan()
+{
+    std::string spaces(64ul << 20, ' ');
+    for (size_t i = 0; i < spaces.size(); i += 4096) spaces[i] = '\n';
+    std::string idents(64ul << 20, 'a');
+    std::string src = gen_program(16ul << 20);
+
+    for (int level = (int) ScanLevel::SCALAR; level <= (int) best_scan_level(); level++)
+    {
+        use_scan_level((ScanLevel) level);
+
+        uint32_t line = 1;
+        size_t line_start = 0, end = 0;
+        double space_ms = time_ms([&] { end = scanners.space(spaces.data(), 0, spaces.size(), line, line_start); });
+        double alnum_ms = time_ms([&] { end += scanners.alnum(idents.data(), 0, idents.size()); });
+        double lex_ms = time_ms([&] { scan(src); });
+
+        printf("  %-6s: whitespace %5.2f GB/s, identifiers %5.2f GB/s, whole lexer %5.2f GB/s\n", level_names[level], spaces.size() / space_ms / 1e6, idents.size() / alnum_ms / 1e6, src.size() / lex_ms / 1e6);
+    }
+
+    use_scan_level(best_scan_level());
+}
+
+static Benchmark lexer("lexer", bench_lexer);
+static Benchmark scan_levels("scan", bench_scan);
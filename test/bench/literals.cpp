@@ -0,0 +1,53 @@
+#include "bench.h"
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "compile.h"
+#include "codegen/codegen.h"
+
+// Functions made of assignments of int and float literals that all need an implicit conversion
+static std::string gen_literals(size_t functions, size_t statements)
+{
+    std::string src;
+    for (size_t f = 0; f < functions; f++)
+    {
+        src += "int f" + std::to_string(f) + "(char c, double d)\n{\n    float x = 1;\n    long l = 2.5;\n";
+        for (size_t s = 0; s < statements; s++)
+        {
+            std::string n = std::to_string(s);
+            src += "    x = x * " + n + ".25;\n    d = d + " + n + ";\n    c = " + n + "0;\n    l = l - " + n + ".75;\n";
+        }
+        src += "    return c;\n}\n\n";
+    }
+    return src;
+}
+
+static void bench_literals()
+{
+    for (size_t statements : {1000, 4000})
+    {
+        std::string src = gen_literals(4, statements);
+        reset_compiler();
+
+        size_t allocs = alloc_count;
+        Node* node = nullptr;
+        double parse_ms = time_ms([&] {
+            node_arena.release();
+            auto tokens = stream(src);
+            node = parse_program(tokens);
+        }, 3);
+        size_t parse_allocs = (alloc_count - allocs) / 3;
+
+        run_passes(node);
+
+        allocs = alloc_count;
+        double codegen_ms = time_ms([&] { codegen(node); }, 3);
+        size_t literals = 4 * (4 * statements + 2);
+        printf("  %5zu literals: parse %6.2f ms, codegen %8.2f ms, %.2f allocations per literal parsing, %.1f per literal in codegen\n", literals, parse_ms, codegen_ms,
+            (double) parse_allocs / literals, (double) (alloc_count - allocs) / 3 / literals);
+    }
+
+    reset_compiler();
+}
+
+static Benchmark literals("literals", bench_literals);
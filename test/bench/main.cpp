@@ -0,0 +1,90 @@
+#include "bench.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <iostream>
+#include <new>
+
+#include "lexer/lexer.h"
+#include "error/error.h"
+
+size_t alloc_count = 0;
+size_t alloc_bytes = 0;
+
+void* operator new(size_t size)
+{
+    alloc_count++;
+    alloc_bytes += size;
+    if (void* ptr = malloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+
+size_t exception_count = 0;
+
+// Every throw allocates its exception through here, so this counts them before handing over to the C++ runtime
+extern "C" void* __cxa_allocate_exception(size_t size) noexcept
+{
+    static auto next = (void* (*)(size_t)) dlsym(RTLD_NEXT, "__cxa_allocate_exception");
+    exception_count++;
+    return next(size);
+}
+
+Benchmark::Benchmark(const char* name, void (*run)())
+    : name(name), run(run)
+{
+    all().push_back(this);
+}
+
+std::vector<Benchmark*>& Benchmark::all()
+{
+    static std::vector<Benchmark*> benchmarks;
+    return benchmarks;
+}
+
+std::string gen_program(size_t bytes)
+{
+    std::string str;
+    str.reserve(bytes + 512);
+
+    for (size_t i = 0; str.size() < bytes; i++)
+    {
+        std::string n = std::to_string(i);
+        str += "int f" + n + "(int a, int b) {\n";
+        str += "    int x = a * 3 + b - 7;\n";
+        str += "    long y = x / 2;\n";
+        str += "    for (int i = 0; i < 10; i++) {\n";
+        str += "        if (x > y && i != 3) x = x + i; else y = y - 1;\n";
+        str += "    }\n";
+        str += "    while (x > 100) x = x - 10;\n";
+        str += "    return x + (int) y;\n";
+        str += "}\n\n";
+    }
+
+    return str;
+}
+
+// Runs every benchmark, or only those whose name contains one of the arguments
+int main(int argc, char** argv)
+{
+    try
+    {
+        for (auto bench : Benchmark::all())
+        {
+            bool selected = argc < 2;
+            for (int i = 1; i < argc; i++) if (strstr(bench->name, argv[i])) selected = true;
+            if (!selected) continue;
+
+            std::cout << "== " << bench->name << std::endl;
+            bench->run();
+        }
+    }
+    catch (compiler_error& e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,113 @@
+#include "bench.h"
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+
+// Parse time and heap traffic of the parser on its own, the tokens are lexed up front
+static void bench_parser()
+{
+    for (size_t size : {1ul << 20, 16ul << 20})
+    {
+        std::string src = gen_program(size);
+        Tokenizer tokens = scan(src);
+
+        double ms = time_ms([&] {
+            node_arena.release();
+            tokens.setPos(0);
+            parse_program(tokens);
+        });
+
+        node_arena.release();
+        tokens.setPos(0);
+        size_t allocs = alloc_count, bytes = alloc_bytes;
+        parse_program(tokens);
+        allocs = alloc_count - allocs;
+        bytes = alloc_bytes - bytes;
+        size_t nodes = node_arena.object_count();
+
+        printf("  %6.1f MB: %9zu nodes in %8.2f ms, %6.1f Mnodes/s\n", src.size() / 1e6, nodes, ms, nodes / ms / 1e3);
+        printf("             %zu allocations, %.3f allocations and %.1f bytes allocated per node, %.1f arena bytes per node\n", allocs, (double) allocs / nodes, (double) bytes / nodes, (double) node_arena.bytes_used() / nodes);
+        node_arena.release();
+    }
+}
+
+static Benchmark parser("parser", bench_parser);
+
+// Long chains of binary operators, so the parser spends its time in the expression loop
+static std::string gen_chains(size_t statements, size_t terms)
+{
+    static const char* ops[] = {" + ", " * ", " - ", " / ", " % ", " < ", " == ", " && ", " || ", " >= "};
+
+    std::string src = "int f(int a, int b)\n{\n    int x = 0;\n";
+    for (size_t i = 0; i < statements; i++)
+    {
+        src += "    x = a";
+        for (size_t j = 1; j < terms; j++)
+        {
+            src += ops[(i + j) % 10];
+            src += (j & 1) ? "b" : "x";
+        }
+        src += ";\n";
+    }
+    src += "    return x;\n}\n";
+    return src;
+}
+
+static void bench_expr()
+{
+    for (size_t terms : {8, 64, 512})
+    {
+        std::string src = gen_chains((4ul << 20) / (terms * 4), terms);
+        Tokenizer tokens = scan(src);
+
+        double ms = time_ms([&] {
+            node_arena.release();
+            tokens.setPos(0);
+            parse_program(tokens);
+        });
+
+        node_arena.release();
+        tokens.setPos(0);
+        size_t allocs = alloc_count;
+        parse_program(tokens);
+        allocs = alloc_count - allocs;
+        size_t nodes = node_arena.object_count();
+
+        printf("  %3zu terms: %8zu nodes in %7.2f ms, %6.1f Mnodes/s, %zu allocations\n", terms, nodes, ms, nodes / ms / 1e3, allocs);
+        node_arena.release();
+    }
+}
+
+static Benchmark expr("expr", bench_expr);
+
+// Parenthesis heavy expressions with the odd cast, every '(' makes the parser look for a type
+static void bench_parens()
+{
+    std::string src = "int f(int a, int b)\n{\n    int x = 0;\n";
+    while (src.size() < (4ul << 20))
+    {
+        src += "    x = ((a + b) * (x - (b + (a * 2)))) / ((x + 1) * (int) (long) (b - a));\n";
+        src += "    x = (((x))) + ((a) * ((b) - (x)));\n";
+    }
+    src += "    return x;\n}\n";
+    Tokenizer tokens = scan(src);
+
+    double ms = time_ms([&] {
+        node_arena.release();
+        tokens.setPos(0);
+        parse_program(tokens);
+    });
+
+    node_arena.release();
+    tokens.setPos(0);
+    size_t allocs = alloc_count, exceptions = exception_count;
+    parse_program(tokens);
+    allocs = alloc_count - allocs;
+    exceptions = exception_count - exceptions;
+    size_t nodes = node_arena.object_count();
+
+    printf("  %6.1f MB: %8zu nodes in %7.2f ms, %6.1f Mnodes/s, %zu allocations, %zu exceptions thrown\n", src.size() / 1e6, nodes, ms, nodes / ms / 1e3, allocs, exceptions);
+    node_arena.release();
+}
+
+static Benchmark parens("parens", bench_parens);
@@ -0,0 +1,42 @@
+#include "bench.h"
+
+#include <algorithm>
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "compile.h"
+#include "codegen/codegen.h"
+
+// The whole compiler from source to IR text, the same steps as main, with the time spent in each stage
+static void bench_pipeline()
+{
+    for (size_t size : {256ul << 10, 1ul << 20})
+    {
+        std::string src = gen_program(size);
+        size_t ir_bytes = 0;
+        double parse_ms = 0, passes_ms = 0, codegen_ms = 0;
+        Node* node = nullptr;
+
+        double ms = time_ms([&] {
+            reset_compiler();
+
+            double t = time_ms([&] {
+                auto tokens = stream(src);
+                node = parse_program(tokens);
+            }, 1);
+            parse_ms = parse_ms ? std::min(parse_ms, t) : t;
+
+            t = time_ms([&] { run_passes(node); }, 1);
+            passes_ms = passes_ms ? std::min(passes_ms, t) : t;
+
+            t = time_ms([&] { ir_bytes = codegen(node).size(); }, 1);
+            codegen_ms = codegen_ms ? std::min(codegen_ms, t) : t;
+        }, 3);
+
+        printf("  %6.1f MB: %8.2f ms (lex+parse %.2f, passes %.2f, codegen %.2f), %.1f MB of IR\n", src.size() / 1e6, ms, parse_ms, passes_ms, codegen_ms, ir_bytes / 1e6);
+    }
+
+    reset_compiler();
+}
+
+static Benchmark pipeline("pipeline", bench_pipeline);
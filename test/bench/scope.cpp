@@ -0,0 +1,104 @@
+#include "bench.h"
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "compile.h"
+#include "codegen/codegen.h"
+
+#include <unordered_map>
+
+// Functions made of deeply nested blocks, each declaring a few locals and using ones from every level above it
+static std::string gen_nested(size_t functions, size_t depth, size_t locals)
+{
+    std::string src;
+    for (size_t f = 0; f < functions; f++)
+    {
+        src += "int f" + std::to_string(f) + "(int a)\n{\n";
+        for (size_t d = 0; d < depth; d++)
+        {
+            for (size_t l = 0; l < locals; l++)
+            {
+                std::string name = "v" + std::to_string(d) + "_" + std::to_string(l);
+                src += "    int " + name + " = a + " + (d ? "v" + std::to_string(d / 2) + "_" + std::to_string(l) : "a") + ";\n";
+            }
+            src += "    a = a + v0_0;\n    {\n";
+        }
+        src += "    a = a + 1;\n";
+        for (size_t d = depth; d > 0; d--) src += "    }\n";
+        src += "    return a;\n}\n\n";
+    }
+    return src;
+}
+
+// The scope operations name resolution does for a gen_nested function, on the vector of maps codegen used to have
+// and on the scoped table, so the table cost can be seen apart from the rest of the compiler
+static size_t scopes_as_maps(size_t depth, size_t locals, const std::vector<SymbolId>& names)
+{
+    std::vector<std::unordered_map<SymbolId, std::pair<std::string, Type>>> var_map;
+    size_t found = 0;
+    for (size_t d = 0; d < depth; d++)
+    {
+        var_map.emplace_back();
+        for (size_t l = 0; l < locals; l++) var_map.back()[names[d * locals + l]] = {"%1", Type{TypeKind::INT, 4}};
+        for (size_t l = 0; l < locals; l++)
+        {
+            SymbolId name = names[d / 2 * locals + l];
+            for (auto i = var_map.rbegin(); i != var_map.rend(); i++)
+            {
+                if (i->contains(name)) { found += (*i)[name].second.size; break; }
+            }
+        }
+    }
+    while (!var_map.empty()) var_map.pop_back();
+    return found;
+}
+
+static size_t scopes_as_table(size_t depth, size_t locals, const std::vector<SymbolId>& names)
+{
+    static ScopedTable<std::pair<std::string, Type>> var_map;
+    size_t found = 0;
+    for (size_t d = 0; d < depth; d++)
+    {
+        var_map.enter();
+        for (size_t l = 0; l < locals; l++) var_map.declare(names[d * locals + l], {"%1", Type{TypeKind::INT, 4}});
+        for (size_t l = 0; l < locals; l++)
+        {
+            if (auto* var = var_map.find(names[d / 2 * locals + l])) found += var->second.size;
+        }
+    }
+    while (var_map.depth()) var_map.leave();
+    return found;
+}
+
+static void bench_scopes()
+{
+    for (size_t depth : {4, 64, 256})
+    {
+        std::vector<SymbolId> names;
+        for (size_t i = 0; i < depth * 32; i++) names.push_back(intern("v" + std::to_string(i / 32) + "_" + std::to_string(i % 32)));
+
+        size_t a = 0, b = 0;
+        double maps_ms = time_ms([&] { for (int i = 0; i < 16; i++) a += scopes_as_maps(depth, 32, names); });
+        double table_ms = time_ms([&] { for (int i = 0; i < 16; i++) b += scopes_as_table(depth, 32, names); });
+        printf("  depth %3zu, 32 locals per block: scopes as maps %8.2f ms, scoped table %6.2f ms%s\n", depth, maps_ms, table_ms, a == b ? "" : " (MISMATCH)");
+    }
+
+    // And the whole of codegen on those functions, only a few of them since codegen's post pass over the output is
+    // quadratic in the number of functions
+    for (size_t depth : {4, 64, 256})
+    {
+        std::string src = gen_nested(4, depth, 32);
+        reset_compiler();
+
+        auto tokens = scan(src);
+        Node* node = parse_program(tokens);
+        run_passes(node);
+
+        double ms = time_ms([&] { codegen(node); }, 3);
+        printf("  depth %3zu, 32 locals per block: %8.2f ms of codegen for %zu declarations\n", depth, ms, 4 * depth * 32);
+    }
+
+    reset_compiler();
+}
+
+static Benchmark scopes("scopes", bench_scopes);
@@ -0,0 +1,26 @@
+int test() {
+    int debug = 0;
+    int unused = 12;
+    int x = 3;
+    int* p = &x;
+    int sink = 0;
+    int* q = &sink;
+    *q = 40;
+    if (0) {
+        x = x * 100;
+    }
+    while (0) {
+        x = x + 1;
+    }
+    if (!debug) {
+        x = x + 4;
+    } else {
+        x = x - 4;
+    }
+    unused = x * 7;
+    for (int i = 0; i < 3; i = i + 1) {
+        if (debug) break;
+        x = x + (1 ? i : 100);
+    }
+    return *p + x;
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+int test() {
+    int a = 10;
+    int s = 0;
+    do {
+        a = a - 1;
+        if (a == 5)
+            continue;
+        if (a == 2)
+            break;
+        s = s + a;
+    } while (a > 0);
+
+    return s;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+long seconds = 60 * 60 * 24;
+int negative = -5;
+unsigned int wrapped = ((unsigned int) 0) - 1;
+double third = ((double) 1) / 3;
+
+int test() {
+    const int scale = 1000;
+    const double half = 0.5;
+    long day = seconds / scale;
+    unsigned int top = wrapped / 2 + 1;
+    int casts = ((long) 3.5) + 1 + ((char) 300);
+    int divs = -7 / 2 * 10 + -7 % 2;
+    int floats = (0.1 + 0.2 == 0.3) + (((float) 0.1) == 0.1) * 2 + !0.0 * 4 + (third * 3 == 1.0) * 8;
+    int logic = (3 > 2 && 2 > 1) + (0 || 5) * 2 + (1 ? 2 : 3.5) * 4 + ~5;
+    int result = day + top / 65536 + casts + divs + floats + logic + negative;
+    return result + ((int) (half * scale)) + (top > 0) * 100000;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+int top = 2147483647.0;
+int bottom = -2147483648.9;
+unsigned char byte = 255.9;
+short low = -32768.5;
+unsigned int big = 4294967295.0;
+long huge = 9007199254740992.0;
+
+int test() {
+    return (top == 2147483647) + (bottom == -2147483647 - 1) * 2 + (byte == 255) * 4 + (low == -32768) * 8 + (big / 2 == 2147483647) * 16 + (huge / 1000000000 == 9007199) * 32;
+}
\ No newline at end of file
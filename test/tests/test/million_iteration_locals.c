@@ -0,0 +1,19 @@
+int test() {
+    int s = 0;
+    for (int i = 0; i < 1000000; i = i + 1) {
+        int x = i % 7;
+        int* p = &x;
+        int y = *p + 1;
+        s = (s + y) % 100003;
+    }
+    int k = 0;
+    while (k < 1000000) {
+        int z = k;
+        int* q = &z;
+        *q = *q % 3;
+        s = (s + z) % 100003;
+        k = k + 1;
+    }
+
+    return s;
+}
\ No newline at end of file
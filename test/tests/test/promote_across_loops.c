@@ -0,0 +1,19 @@
+int test() {
+    int s = 0;
+    int k = 1;
+    int* p = &k;
+    for (int i = 0; i < 10; i = i + 1) {
+        int j = i;
+        while (j > 0) {
+            if (j == 4)
+                break;
+            s = s + (j > 2 ? j : *p);
+            j = j - 1;
+        }
+        if (i == 7)
+            continue;
+        *p = *p + 1;
+    }
+
+    return s + k;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+int g = 3;
+int h = 4;
+
+int bump(int* p) {
+    *p = *p + 1;
+    g = g + *p;
+    return *p;
+}
+
+int test() {
+    int a = 6;
+    int b = 7;
+    int x = a * b + g;
+    int y = a * b - g;
+    int* p = &h;
+    int before = *p + h;
+    *p = 10;
+    int after = h + *p;
+    int local = 5;
+    int* q = &local;
+    int c = g + local;
+    c = c + bump(q) + g + local;
+    int* r = &g;
+    *r = 1;
+    int e = g;
+    if (x > y) {
+        e = e + g * (a * b);
+        *q = *q + 1;
+    }
+    e = e + local * (a * b);
+    return x + y + before + after + c + e;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+// Every local has to get its stack slot in the entry block, and locals of sibling scopes have to share slots
+// An alloca in a loop body takes more stack every iteration, and one per local makes big functions' frames grow
+
+#include "unit.h"
+#include "ir/passes.h"
+#include "error/error.h"
+
+#include <cstdio>
+#include <string>
+
+// One function with a loop per scope, each with an address-taken local and a local that is only read and written
+std::string gen_scopes(size_t scopes)
+{
+    std::string src = "int f(int n)\n{\n    int s = 0;\n";
+    for (size_t i = 0; i < scopes; i++)
+    {
+        std::string k = std::to_string(i);
+        src += "    for (int i = 0; i < n; i++)\n    {\n        int x = i + " + k + ";\n        int y = x * 2;\n"
+            "        int* p = &x;\n        s = s + *p + y;\n    }\n";
+    }
+    src += "    return s;\n}\n";
+    return src;
+}
+
+// The allocas of the defined function, and how many of them aren't in the entry block
+size_t count_allocas(const Function& fn, size_t* outside_entry)
+{
+    size_t count = 0;
+    *outside_entry = 0;
+    for (BlockId block : fn.layout)
+    {
+        for (InstId i = fn.blocks[block].first; i != NO_ID; i = fn.insts[i].next)
+        {
+            if (fn.insts[i].op != Op::ALLOCA) continue;
+            count++;
+            if (block != fn.layout.front()) (*outside_entry)++;
+        }
+    }
+    return count;
+}
+
+int main(void)
+{
+    int failed = 0;
+    try
+    {
+        for (size_t scopes = 1; scopes <= 64; scopes *= 4)
+        {
+            Module ir = build_ir(gen_scopes(scopes));
+            Function* fn = nullptr;
+            for (Function& f : ir.functions) if (f.defined) fn = &f;
+
+            // The argument, s, i, x, y and p, however many loops there are
+            size_t outside = 0;
+            size_t allocas = count_allocas(*fn, &outside);
+            printf("frames: %2zu scopes, %zu allocas, %zu outside the entry block\n", scopes, allocas, outside);
+            if (outside != 0 || allocas != 6)
+            {
+                printf("frames: locals of sibling scopes didn't share hoisted slots\n");
+                failed++;
+                break;
+            }
+
+            // Only x is left, the address-taken local has a slot of its own so y can still be promoted
+            promote_allocas(ir, *fn);
+            allocas = count_allocas(*fn, &outside);
+            if (allocas != 1)
+            {
+                printf("frames: %zu allocas are left after promotion, expected 1\n", allocas);
+                failed++;
+                break;
+            }
+        }
+    }
+    catch (compiler_error& e)
+    {
+        printf("frames: %s\n", e.what());
+        failed++;
+    }
+
+    node_arena.release();
+    return failed != 0;
+}
@@ -0,0 +1,57 @@
+// A global initialized with a float that doesn't fit its integer type has to be rejected
+// The conversion has no defined result, so there is no value dcc could give the global
+
+#include "unit.h"
+#include "error/error.h"
+
+#include <cstdio>
+#include <string>
+
+// If compiling src throws a compiler error
+bool rejected(const std::string& src)
+{
+    try
+    {
+        build_ir(src);
+    }
+    catch (compiler_error&)
+    {
+        return true;
+    }
+    return false;
+}
+
+int main(void)
+{
+    int failed = 0;
+    const char* out_of_range[] = {
+        "int g = 10000000000000000000000000000.0;\n",
+        "int g = 2147483648.0;\n",
+        "unsigned char g = -1.0;\n",
+        "short g = 32768.0;\n",
+        "long g = 9223372036854775808.0;\n",
+    };
+    for (const char* global : out_of_range)
+    {
+        if (rejected(std::string(global) + "int main() { return g; }\n")) continue;
+        printf("global_range: accepted %s", global);
+        failed++;
+    }
+
+    // The largest values that still fit once truncated
+    const char* in_range[] = {
+        "int g = 2147483647.9;\n",
+        "unsigned char g = 255.5;\n",
+        "short g = -32768.5;\n",
+    };
+    for (const char* global : in_range)
+    {
+        if (!rejected(std::string(global) + "int main() { return g; }\n")) continue;
+        printf("global_range: rejected %s", global);
+        failed++;
+    }
+
+    printf("global_range: %zu out of range and %zu in range initializers checked\n", std::size(out_of_range), std::size(in_range));
+    node_arena.release();
+    return failed != 0;
+}
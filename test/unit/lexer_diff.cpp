@@ -0,0 +1,86 @@
+// Differential test for the lexer, every scan level has to give the same token stream as the scalar one
+// Runs over the test corpus and randomly generated inputs
+
+#include "lexer/lexer.h"
+#include "lexer/simd.h"
+#include "error/error.h"
+#include "util.h"
+
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Everything about the token stream, or the error if lexing failed
+std::string lex_all(const std::string& src, ScanLevel level)
+{
+    use_scan_level(level);
+
+    std::stringstream out;
+    try
+    {
+        auto tokens = scan(src);
+        for (size_t i = 0; i <= tokens.size(); i++)
+        {
+            Token tok = tokens[i];
+            out << (int) tok.type << " " << tok.value << " " << tok.loc.line << ":" << tok.loc.col << "\n";
+        }
+    }
+    catch (compiler_error& e)
+    {
+        out << "error " << e.what() << "\n";
+    }
+    return out.str();
+}
+
+// Random input made of runs of one kind of character, so runs cross the simd block boundaries
+std::string random_input(std::mt19937& rng)
+{
+    const std::vector<std::string> kinds = {
+        " \t\r\n", "    ", "\n", "abcxyzABCXYZ_", "0123456789", "0123456789.", "+-*/%&|=!<>?:;,(){}~", "intlongreturnwhile", "-1", "\x80\xff\x01@#$",
+    };
+
+    std::string str;
+    size_t runs = rng() % 40;
+    for (size_t i = 0; i < runs; i++)
+    {
+        const std::string& kind = kinds[rng() % kinds.size()];
+        size_t len = rng() % 70;
+        for (size_t j = 0; j < len; j++) str.push_back(kind[rng() % kind.size()]);
+    }
+    return str;
+}
+
+int main(void)
+{
+    std::vector<ScanLevel> levels;
+    for (int level = (int) ScanLevel::SSE2; level <= (int) best_scan_level(); level++) levels.push_back((ScanLevel) level);
+
+    std::vector<std::string> inputs;
+    for (auto file : std::filesystem::directory_iterator("test/tests/test"))
+    {
+        if (file.path().extension() == ".c") inputs.push_back(read_file(file.path().string()));
+    }
+    size_t corpus = inputs.size();
+
+    std::mt19937 rng(1234);
+    for (size_t i = 0; i < 20000; i++) inputs.push_back(random_input(rng));
+
+    size_t failed = 0;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        std::string expected = lex_all(inputs[i], ScanLevel::SCALAR);
+        for (auto level : levels)
+        {
+            if (lex_all(inputs[i], level) != expected)
+            {
+                std::cout << "Mismatch at scan level " << (int) level << " on input " << i << (i < corpus ? " (corpus)" : " (random)") << "\n";
+                failed++;
+            }
+        }
+    }
+
+    std::cout << "lexer_diff: " << inputs.size() << " inputs, " << levels.size() << " simd levels, " << failed << " mismatches" << std::endl;
+    return failed != 0;
+}
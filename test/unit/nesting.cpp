@@ -0,0 +1,60 @@
+// Codegen has to do work linear in how deeply ternaries and logical ops are nested
+// Each node used to be emitted once per enclosing ternary (the rhs was emitted twice to find its type), which is exponential
+
+#include "unit.h"
+#include "error/error.h"
+
+#include <cstdio>
+#include <string>
+
+// Functions returning a ternary chain nested in the rhs, and a logical chain nested the same way
+std::string gen_nested(size_t depth)
+{
+    std::string src;
+    for (size_t f = 0; f < 8; f++)
+    {
+        src += "int t" + std::to_string(f) + "(int a, int b)\n{\n    return ";
+        for (size_t d = 0; d < depth; d++) src += "a == " + std::to_string(d) + " ? b + " + std::to_string(d) + " : ";
+        src += "0;\n}\n\n";
+
+        src += "int l" + std::to_string(f) + "(int a, int b)\n{\n    return ";
+        for (size_t d = 0; d < depth; d++) src += (d % 2 ? "a < " : "b > ") + std::to_string(d) + (d % 3 ? " && (" : " || (");
+        src += "a";
+        for (size_t d = 0; d < depth; d++) src += ")";
+        src += ";\n}\n\n";
+    }
+    return src;
+}
+
+int main(void)
+{
+    int failed = 0;
+    try
+    {
+        // The instructions built per level of nesting have to stay the same as at the shallowest depth, anything
+        // emitted more than once per level makes them grow with the depth, the time is only printed
+        double base = (double) built_insts(build_ir(gen_nested(8))) / 8;
+        double base_ms = compile_ms(gen_nested(8)) / 8;
+        for (size_t depth = 16; depth <= 256; depth *= 2)
+        {
+            double per_level = (double) built_insts(build_ir(gen_nested(depth))) / depth;
+            double ms = compile_ms(gen_nested(depth));
+            printf("nesting: depth %3zu, %7.1f instructions per level (%.2fx depth 8), %8.3f ms (%.2fx the time per level)\n",
+                depth, per_level, per_level / base, ms, ms / depth / base_ms);
+            if (per_level > 1.1 * base)
+            {
+                printf("nesting: the instructions built grew faster than the nesting depth\n");
+                failed++;
+                break;
+            }
+        }
+    }
+    catch (compiler_error& e)
+    {
+        printf("nesting: %s\n", e.what());
+        failed++;
+    }
+
+    node_arena.release();
+    return failed != 0;
+}
@@ -0,0 +1,91 @@
+// Codegen has to do work linear in the number of early returns in a function
+// Unreachable branches after a return used to be erased from the output text one at a time, which is quadratic
+
+#include "unit.h"
+#include "error/error.h"
+
+#include <cstdio>
+#include <string>
+
+// One function with returns ending if bodies, loop bodies, and the blocks they are in
+std::string gen_returns(size_t returns)
+{
+    std::string src = "int f(int a, int b)\n{\n";
+    for (size_t r = 0; r < returns; r++)
+    {
+        std::string n = std::to_string(r);
+        switch (r % 3)
+        {
+            case 0: src += "    if (a == " + n + ") return b + " + n + ";\n"; break;
+            case 1: src += "    if (b < " + n + ") { b = b + 1; return a; } else return b;\n"; break;
+            case 2: src += "    while (a > " + n + ") { return a - b; }\n"; break;
+        }
+    }
+    src += "    return 0;\n}\n";
+    return src;
+}
+
+// Every block has to end in exactly one terminator, so no br or ret may follow another without a label in between
+bool terminators_valid(const std::string& ir)
+{
+    bool closed = false;
+    size_t line = 0;
+    while (line < ir.size())
+    {
+        size_t end = ir.find('\n', line);
+        std::string_view str(ir.data() + line, end - line);
+        line = end + 1;
+
+        if (str.empty()) continue;
+        if (str.starts_with("    br ") || str.starts_with("    ret "))
+        {
+            if (closed) return false;
+            closed = true;
+        }
+        else if (!str.starts_with("    ")) closed = false;
+        else if (closed) return false;
+    }
+    return true;
+}
+
+int main(void)
+{
+    int failed = 0;
+    try
+    {
+        std::string ir;
+
+        // The instructions built per return have to stay the same as with the fewest returns, the time is only printed
+        std::string src = gen_returns(1000);
+        double base = (double) built_insts(build_ir(src)) / 1000;
+        double base_ms = compile_ms(src, &ir) / 1000;
+        for (size_t returns = 2000; returns <= 32000; returns *= 2)
+        {
+            src = gen_returns(returns);
+            double insts = (double) built_insts(build_ir(src)) / returns;
+            double ms = compile_ms(src, &ir);
+            printf("returns: %5zu returns, %5.2f instructions per return (%.2fx at 1000), %8.3f ms (%.2fx the time per return)\n",
+                returns, insts, insts / base, ms, ms / returns / base_ms);
+            if (!terminators_valid(ir))
+            {
+                printf("returns: a block has code after its terminator\n");
+                failed++;
+                break;
+            }
+            if (insts > 1.1 * base)
+            {
+                printf("returns: the instructions built grew faster than the number of returns\n");
+                failed++;
+                break;
+            }
+        }
+    }
+    catch (compiler_error& e)
+    {
+        printf("returns: %s\n", e.what());
+        failed++;
+    }
+
+    node_arena.release();
+    return failed != 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "compile.h"
+#include "codegen/codegen.h"
+
+// std
+#include <chrono>
+#include <string>
+
+// What the unit tests share, every program is compiled with the same passes as dcc
+
+// Fastest of a few compiles of src to IR text, in milliseconds, the text is put in ir if one is given
+inline double compile_ms(const std::string& src, std::string* ir = nullptr)
+{
+    double best = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        reset_compiler();
+        auto start = std::chrono::steady_clock::now();
+        auto tokens = scan(src);
+        std::string out = compile(tokens);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || ms < best) best = ms;
+        if (ir) *ir = std::move(out);
+    }
+    return best;
+}
+
+// The IR of src before it is optimized
+inline Module build_ir(const std::string& src)
+{
+    reset_compiler();
+    auto tokens = scan(src);
+    Node* node = parse_program(tokens);
+    run_passes(node);
+    return generate_ir(node);
+}
+
+// Every instruction codegen built, including the ones it removed again, so a node emitted twice is counted twice
+inline size_t built_insts(const Module& ir)
+{
+    size_t insts = 0;
+    for (const Function& fn : ir.functions) insts += fn.insts.size();
+    return insts;
+}